@@ -0,0 +1,79 @@
+/**
+ * Batch predicates over blocks of states. A block holds up to 64 states in structure-of-arrays form, one column of
+ * small integers per state field, and a batch predicate returns a mask with bit i set when state i satisfies it.
+ * Written as loops over the lanes of a column, such predicates have no branches per state and vectorize well.
+ * States take part by specializing state_columns.
+ */
+
+#ifndef PUZZLEENGINE_BATCH_HPP
+#define PUZZLEENGINE_BATCH_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+
+// Describes how a state is split into a fixed number of integer columns. Specializations set supported to true and
+// provide the column value_type, the number of columns as count, and a static pack(state, row) function that writes
+// the count column values of the state into row.
+template<class StateTypeT, class Enable = void>
+struct state_columns {
+    static constexpr bool supported = false;
+};
+
+// A block of states in structure-of-arrays form. columns[c][lane] is the value of column c of the state in that lane.
+// Only the lanes before size hold states; the columns are left uninitialised, so a block costs nothing to create.
+template<class StateTypeT>
+struct soa_block_t {
+    using layout_t = state_columns<StateTypeT>;
+    using value_type = typename layout_t::value_type;
+    static constexpr std::size_t lanes = 64;
+
+    std::array<std::array<value_type, lanes>, layout_t::count> columns;
+    std::size_t size{0};
+
+    void clear() {
+        size = 0;
+    }
+
+    bool full() const {
+        return size == lanes;
+    }
+
+    void push(const StateTypeT &state) {
+        std::array<value_type, layout_t::count> row;
+        layout_t::pack(state, row.data());
+        for (std::size_t column = 0; column < layout_t::count; ++column) {
+            columns[column][size] = row[column];
+        }
+        ++size;
+    }
+};
+
+// A predicate over a whole block, returning the mask of the lanes that satisfy it. Lanes at or beyond the size of the
+// block hold no states and must not be read.
+template<class StateTypeT>
+using batch_predicate_t = std::function<std::uint64_t(const soa_block_t<StateTypeT> &)>;
+
+// Turns one flag per lane, as computed by a loop over the lanes, into a mask of the first size lanes.
+template<std::size_t lanes>
+std::uint64_t lane_mask(const std::array<std::uint8_t, lanes> &flags, std::size_t size) {
+    std::uint64_t mask = 0;
+    for (std::size_t lane = 0; lane < size; ++lane) {
+        mask |= static_cast<std::uint64_t>(flags[lane] != 0) << lane;
+    }
+    return mask;
+}
+
+// Tells whether FunctionT is a batch predicate for StateTypeT rather than a predicate on a single state.
+template<class StateTypeT, class FunctionT, bool = state_columns<StateTypeT>::supported>
+struct is_batch_predicate : std::false_type {
+};
+
+template<class StateTypeT, class FunctionT>
+struct is_batch_predicate<StateTypeT, FunctionT, true>
+        : std::is_invocable_r<std::uint64_t, FunctionT, const soa_block_t<StateTypeT> &> {
+};
+
+#endif //PUZZLEENGINE_BATCH_HPP
@@ -0,0 +1,194 @@
+/**
+ * Saving and restoring a running search to and from a local file. A checkpoint holds the start state, the counters,
+ * the trace store and the passed and waiting lists, so a new process can continue the search where it stopped.
+ * Both states and costs are written with the state_serializer trait.
+ */
+
+#ifndef PUZZLEENGINE_CHECKPOINT_HPP
+#define PUZZLEENGINE_CHECKPOINT_HPP
+
+#include "serialization.hpp"
+#include "search_state.hpp"
+
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+// Set by checkpoint_signal_handler and picked up by a running search, which then saves itself before continuing.
+inline volatile std::sig_atomic_t checkpoint_requested = 0;
+
+// Can be installed with std::signal, e.g. std::signal(SIGUSR1, checkpoint_signal_handler), to request a checkpoint
+// of the running search from outside the process.
+inline void checkpoint_signal_handler(int) {
+    checkpoint_requested = 1;
+}
+
+// The settings for saving a search. A checkpoint is written every interval expansions when interval is not zero, and
+// whenever a checkpoint is requested by signal. An empty path disables checkpoints.
+struct checkpoint_options_t {
+    std::string path;
+    std::size_t interval{0};
+};
+
+// The waiting list elements differ between ordered and cost searches, so this helper knows how to write each kind
+// given a map from trace_node to its position in the trace store.
+template<class StateTypeT, class WaitingT>
+struct waiting_serializer;
+
+template<class StateTypeT>
+struct waiting_serializer<StateTypeT, trace_node<StateTypeT> *> {
+    static constexpr bool supported = true;
+    using node_t = trace_node<StateTypeT>;
+
+    static void write(std::ostream &out, node_t *const &element,
+                      const std::unordered_map<const node_t *, std::uint64_t> &index) {
+        state_serializer<std::uint64_t>::write(out, index.at(element));
+    }
+
+    static bool read(std::istream &in, node_t *&element, trace_arena_t<node_t> &traces) {
+        std::uint64_t position{};
+        if (!state_serializer<std::uint64_t>::read(in, position) || position >= traces.size()) {
+            return false;
+        }
+        element = &traces[position];
+        return true;
+    }
+};
+
+template<class StateTypeT, class CostTypeT>
+struct waiting_serializer<StateTypeT, std::pair<CostTypeT, trace_node<StateTypeT> *>> {
+    static constexpr bool supported = state_serializer<CostTypeT>::supported;
+    using node_t = trace_node<StateTypeT>;
+
+    static void write(std::ostream &out, const std::pair<CostTypeT, node_t *> &element,
+                      const std::unordered_map<const node_t *, std::uint64_t> &index) {
+        state_serializer<CostTypeT>::write(out, element.first);
+        waiting_serializer<StateTypeT, node_t *>::write(out, element.second, index);
+    }
+
+    static bool read(std::istream &in, std::pair<CostTypeT, node_t *> &element, trace_arena_t<node_t> &traces) {
+        return state_serializer<CostTypeT>::read(in, element.first) &&
+               waiting_serializer<StateTypeT, node_t *>::read(in, element.second, traces);
+    }
+};
+
+// Tells whether a search over StateTypeT with waiting elements WaitingT can be written to a checkpoint.
+template<class StateTypeT, class WaitingT>
+constexpr bool is_checkpointable_v = state_serializer<StateTypeT>::supported &&
+                                     waiting_serializer<StateTypeT, WaitingT>::supported;
+
+constexpr char checkpoint_magic[8] = {'P', 'E', 'C', 'K', 'P', 'T', '0', '1'};
+
+// Writes the search to path. The file is first written next to the target and then renamed, so an interrupted save
+// never destroys the previous checkpoint. The kind separates the different search orders, as a breadth first
+// checkpoint cannot be continued as a depth first search. Returns false if the file could not be written.
+template<class StateTypeT, class WaitingT, class WaitingListT>
+bool save_checkpoint(const std::string &path, std::uint8_t kind, const StateTypeT &startState,
+                     const search_state_t<StateTypeT, WaitingT, WaitingListT> &search) {
+    using node_t = trace_node<StateTypeT>;
+    const auto temporaryPath = path + ".tmp";
+    std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+
+    out.write(checkpoint_magic, sizeof(checkpoint_magic));
+    state_serializer<std::uint8_t>::write(out, kind);
+    state_serializer<StateTypeT>::write(out, startState);
+    state_serializer<search_statistics_t>::write(out, search.statistics);
+
+    // The trace store is written in order, which guarantees that a parent is always written before its children.
+    std::unordered_map<const node_t *, std::uint64_t> index;
+    index.reserve(search.traces.size());
+    state_serializer<std::uint64_t>::write(out, search.traces.size());
+    for (std::size_t position = 0; position < search.traces.size(); ++position) {
+        auto &node = search.traces[position];
+        std::uint64_t parent = node.parentState == nullptr ? 0 : index.at(node.parentState) + 1;
+        index.emplace(&node, index.size());
+        state_serializer<std::uint64_t>::write(out, parent);
+        state_serializer<StateTypeT>::write(out, node.selfState);
+    }
+
+    state_serializer<std::uint64_t>::write(out, search.passed.size());
+    search.passed.for_each([&out](const StateTypeT &state) {
+        state_serializer<StateTypeT>::write(out, state);
+    });
+
+    state_serializer<std::uint64_t>::write(out, search.waiting.size());
+    for_each_waiting(search.waiting, [&out, &index](const WaitingT &element) {
+        waiting_serializer<StateTypeT, WaitingT>::write(out, element, index);
+    });
+
+    out.close();
+    if (!out) {
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    return std::rename(temporaryPath.c_str(), path.c_str()) == 0;
+}
+
+// Restores a search from path into search. Returns false, leaving search empty, if there is no checkpoint or if it was
+// written for another kind of search or another start state.
+template<class StateTypeT, class WaitingT, class WaitingListT>
+bool load_checkpoint(const std::string &path, std::uint8_t kind, const StateTypeT &startState,
+                     search_state_t<StateTypeT, WaitingT, WaitingListT> &search) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+
+    char magic[sizeof(checkpoint_magic)];
+    std::uint8_t savedKind{};
+    StateTypeT savedStart{startState};
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, checkpoint_magic, sizeof(magic)) != 0 ||
+        !state_serializer<std::uint8_t>::read(in, savedKind) || savedKind != kind ||
+        !state_serializer<StateTypeT>::read(in, savedStart) || !(savedStart == startState)) {
+        return false;
+    }
+
+    auto restored = search_state_t<StateTypeT, WaitingT, WaitingListT>{};
+    restored.passed.set_layout(search.passed.layout());
+    std::uint64_t count{};
+    bool valid = state_serializer<search_statistics_t>::read(in, restored.statistics) &&
+                 state_serializer<std::uint64_t>::read(in, count);
+    for (std::uint64_t i = 0; valid && i < count; ++i) {
+        std::uint64_t parent{};
+        StateTypeT state{startState};
+        valid = state_serializer<std::uint64_t>::read(in, parent) && parent <= restored.traces.size() &&
+                state_serializer<StateTypeT>::read(in, state);
+        if (valid) {
+            restored.addTrace(parent == 0 ? nullptr : &restored.traces[parent - 1], state);
+        }
+    }
+
+    valid = valid && state_serializer<std::uint64_t>::read(in, count);
+    for (std::uint64_t i = 0; valid && i < count; ++i) {
+        StateTypeT state{startState};
+        valid = state_serializer<StateTypeT>::read(in, state);
+        if (valid) {
+            restored.passed.insert(state);
+        }
+    }
+
+    valid = valid && state_serializer<std::uint64_t>::read(in, count);
+    for (std::uint64_t i = 0; valid && i < count; ++i) {
+        WaitingT element{};
+        valid = waiting_serializer<StateTypeT, WaitingT>::read(in, element, restored.traces);
+        if (valid) {
+            push_waiting(restored.waiting, element);
+        }
+    }
+
+    if (!valid) {
+        return false;
+    }
+    search = std::move(restored);
+    return true;
+}
+
+#endif //PUZZLEENGINE_CHECKPOINT_HPP
@@ -0,0 +1,206 @@
+/**
+ * State spaces compiled into tables. A state type with a state_rank specialization numbers its states densely, so a
+ * small model can be enumerated once: every state gets a validity bit and the ranks of its valid successors, in the
+ * order the transitions generate them. Queries then run over the tables alone, without calling the transitions or
+ * the invariant. Spaces of up to compiled_space_t::max_tabled states also get the breadth first search from every
+ * start state precomputed: the order in which the search takes the states from waiting and the parent of each
+ * state, so a query only walks these tables.
+ */
+
+#ifndef PUZZLEENGINE_COMPILED_SPACE_HPP
+#define PUZZLEENGINE_COMPILED_SPACE_HPP
+
+#include "search_state.hpp"
+#include "scratch_pool.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <vector>
+
+// Numbers the states of a small state type: count is the number of states, rank maps a state to a number below
+// count and unrank(rank, state) restores it. Types opt in by specializing the trait with supported set to true.
+template<class StateTypeT, class Enable = void>
+struct state_rank {
+    static constexpr bool supported = false;
+};
+
+// The tables of a compiled state space, made by state_space_t::compile. The queries give the same traces as a breadth
+// first check() of the state space they were compiled from.
+template<class StateTypeT>
+class compiled_space_t {
+public:
+    using rank_t = std::uint32_t;
+    static constexpr rank_t npos = UINT32_MAX;
+    // The largest space for which the searches from all start states are precomputed, which takes eight bytes per
+    // pair of states.
+    static constexpr std::size_t max_tabled = 512;
+
+    // Takes the validity of every state and the successors of state r at targets[offsets[r]] to
+    // targets[offsets[r + 1]].
+    compiled_space_t(std::vector<bool> valid, std::vector<rank_t> offsets, std::vector<rank_t> targets)
+            : _offsets(std::move(offsets)), _targets(std::move(targets)), _valid((valid.size() + 63) / 64) {
+        for (std::size_t rank = 0; rank < valid.size(); ++rank) {
+            _valid[rank / 64] |= static_cast<std::uint64_t>(valid[rank]) << (rank % 64);
+        }
+        if (size() <= max_tabled) {
+            tabulate();
+        }
+    }
+
+    std::size_t size() const {
+        return _offsets.size() - 1;
+    }
+
+    bool tabled() const {
+        return !_parents.empty();
+    }
+
+    // Tells whether the state with the given rank satisfies the invariant.
+    bool valid(rank_t rank) const {
+        return (_valid[rank / 64] >> (rank % 64)) & 1u;
+    }
+
+    // The ranks of the valid successors of a state, in the order of its transitions.
+    struct successors_t {
+        const rank_t *first;
+        const rank_t *last;
+
+        const rank_t *begin() const {
+            return first;
+        }
+
+        const rank_t *end() const {
+            return last;
+        }
+    };
+
+    successors_t successors(rank_t rank) const {
+        return successors_t{_targets.data() + _offsets[rank], _targets.data() + _offsets[rank + 1]};
+    }
+
+    // Writes the ranks of the breadth first trace from start to target into trace and returns whether target is
+    // reachable. On a tabled space this only follows the parent table.
+    bool trace(rank_t start, rank_t target, std::vector<rank_t> &trace) const {
+        trace.clear();
+        if (tabled()) {
+            if (start != target && _parents[start * size() + target] == npos) {
+                return false;
+            }
+            for (auto rank = target; rank != start; rank = _parents[start * size() + rank]) {
+                trace.push_back(rank);
+            }
+            trace.push_back(start);
+        } else {
+            auto scratch = scratch_pool_t<search_t>::acquire();
+            auto found = search(start, [target](rank_t rank) { return rank == target; }, *scratch);
+            for (auto rank = found; rank != npos; rank = scratch->parents[rank]) {
+                trace.push_back(rank);
+            }
+        }
+        std::reverse(trace.begin(), trace.end());
+        return !trace.empty();
+    }
+
+    // Searches breadth first from start for a state satisfying isGoalState, like check() on the original state space.
+    // On a tabled space the states are checked in the precomputed order.
+    template<class ValidationFunction>
+    std::list<StateTypeT> check(const StateTypeT &start, ValidationFunction isGoalState) const {
+        std::list<StateTypeT> solution;
+        StateTypeT state{start};
+        const auto first = static_cast<rank_t>(state_rank<StateTypeT>::rank(start));
+        auto isGoal = [&](rank_t rank) {
+            state_rank<StateTypeT>::unrank(rank, state);
+            return isGoalState(state);
+        };
+        auto found = npos;
+        std::vector<rank_t> path;
+        if (tabled()) {
+            for (auto index = _orderOffsets[first]; index < _orderOffsets[first + 1]; ++index) {
+                if (isGoal(_order[index])) {
+                    found = _order[index];
+                    break;
+                }
+            }
+            if (found != npos) {
+                trace(first, found, path);
+            }
+        } else {
+            auto scratch = scratch_pool_t<search_t>::acquire();
+            found = search(first, isGoal, *scratch);
+            for (auto rank = found; rank != npos; rank = scratch->parents[rank]) {
+                path.insert(path.begin(), rank);
+            }
+        }
+        for (auto rank: path) {
+            state_rank<StateTypeT>::unrank(rank, state);
+            solution.push_back(state);
+        }
+        return solution;
+    }
+
+private:
+    // The working data of a breadth first search over the tables.
+    struct search_t {
+        std::vector<rank_t> parents;
+        std::vector<std::uint8_t> reached;
+        waiting_list_t<rank_t> waiting;
+
+        void clear() {
+            parents.clear();
+            reached.clear();
+            waiting.clear();
+        }
+    };
+
+    std::vector<rank_t> _offsets;
+    std::vector<rank_t> _targets;
+    std::vector<std::uint64_t> _valid;
+    std::vector<rank_t> _parents;      // the parent of every state in the search from every start state
+    std::vector<rank_t> _order;        // the states of every search in the order they are taken from waiting
+    std::vector<rank_t> _orderOffsets; // where the order of each start state begins
+
+    // Breadth first search from start, returning the first state taken from waiting that satisfies isGoal, or npos.
+    // Recording the parent when a state is first reached gives the trace of check(), which keeps duplicates in
+    // waiting: the first copy of a state is pushed by the first state that reaches it, and it is taken first.
+    template<class GoalT>
+    rank_t search(rank_t start, GoalT isGoal, search_t &scratch) const {
+        scratch.parents.assign(size(), npos);
+        scratch.reached.assign(size(), 0);
+        scratch.reached[start] = 1;
+        scratch.waiting.push_back(start);
+        while (!scratch.waiting.empty()) {
+            const auto rank = scratch.waiting.front();
+            scratch.waiting.pop_front();
+            if (isGoal(rank)) {
+                return rank;
+            }
+            for (auto successor: successors(rank)) {
+                if (!scratch.reached[successor]) {
+                    scratch.reached[successor] = 1;
+                    scratch.parents[successor] = rank;
+                    scratch.waiting.push_back(successor);
+                }
+            }
+        }
+        return npos;
+    }
+
+    void tabulate() {
+        search_t scratch;
+        _parents.resize(size() * size());
+        _orderOffsets.push_back(0);
+        for (rank_t start = 0; start < size(); ++start) {
+            search(start, [this](rank_t rank) {
+                _order.push_back(rank);
+                return false;
+            }, scratch);
+            std::copy(scratch.parents.begin(), scratch.parents.end(), _parents.begin() + start * size());
+            _orderOffsets.push_back(static_cast<rank_t>(_order.size()));
+            scratch.clear();
+        }
+    }
+};
+
+#endif //PUZZLEENGINE_COMPILED_SPACE_HPP
@@ -0,0 +1,147 @@
+/**
+ * A breadth first search that the compiler can run. Small puzzles with a fixed start state and goal can be solved
+ * while compiling, and the trace embedded in the program as a constexpr value, so no search runs at all when the
+ * program does. Everything here lives in fixed capacity arrays instead of lists and hash tables, and the successors,
+ * invariant and goal are plain constexpr functions instead of std::function objects. The capacities are template
+ * arguments, chosen from the size of the state space.
+ */
+
+#ifndef PUZZLEENGINE_CONSTEXPR_SEARCH_HPP
+#define PUZZLEENGINE_CONSTEXPR_SEARCH_HPP
+
+#include <array>
+#include <cstddef>
+
+// A vector with a fixed capacity of N elements, usable in constant expressions. Elements pushed beyond the capacity
+// are dropped and mark the vector as overflowed.
+template<class T, std::size_t N>
+class fixed_vector_t {
+public:
+    constexpr void push_back(const T &value) {
+        if (_size < N) {
+            _items[_size++] = value;
+        } else {
+            _overflowed = true;
+        }
+    }
+
+    constexpr void pop_back() {
+        --_size;
+    }
+
+    constexpr const T &operator[](std::size_t index) const {
+        return _items[index];
+    }
+
+    constexpr T &operator[](std::size_t index) {
+        return _items[index];
+    }
+
+    constexpr const T &back() const {
+        return _items[_size - 1];
+    }
+
+    constexpr std::size_t size() const {
+        return _size;
+    }
+
+    constexpr bool empty() const {
+        return _size == 0;
+    }
+
+    constexpr bool overflowed() const {
+        return _overflowed;
+    }
+
+    constexpr const T *begin() const {
+        return _items;
+    }
+
+    constexpr const T *end() const {
+        return _items + _size;
+    }
+
+private:
+    T _items[N]{};
+    std::size_t _size = 0;
+    bool _overflowed = false;
+};
+
+// Equality usable in constant expressions, as operator== of std::array is not constexpr before C++20.
+template<class T>
+constexpr bool constexpr_equal(const T &a, const T &b) {
+    return a == b;
+}
+
+template<class T, std::size_t N>
+constexpr bool constexpr_equal(const std::array<T, N> &a, const std::array<T, N> &b) {
+    for (std::size_t i = 0; i < N; ++i) {
+        if (!constexpr_equal(a[i], b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The outcome of constexpr_check: the trace from the start state to the goal, empty if the goal cannot be reached,
+// and whether the search ran to its end. A search that ran out of capacity is not complete and has no trace.
+template<class StateTypeT, std::size_t MaxStates>
+struct constexpr_result_t {
+    fixed_vector_t<StateTypeT, MaxStates> trace;
+    bool complete = false;
+};
+
+// Searches breadth first from start for a state satisfying isGoalState, like state_space_t::check, and returns the
+// same trace. successors(state, out) pushes the successors of a state into a fixed_vector_t<StateTypeT,
+// MaxSuccessors> in the order of the transitions, and isValid is the invariant. MaxStates bounds the number of states
+// reached. Duplicates are dropped when they are generated, which keeps the trace of check(): the first copy of a state
+// in waiting is the one pushed by the first state that reaches it.
+template<std::size_t MaxStates, std::size_t MaxSuccessors, class StateTypeT, class SuccessorsT, class InvariantT,
+         class ValidationFunction>
+constexpr constexpr_result_t<StateTypeT, MaxStates>
+constexpr_check(const StateTypeT &start, SuccessorsT successors, InvariantT isValid, ValidationFunction isGoalState) {
+    constexpr std::size_t none = MaxStates;
+    constexpr_result_t<StateTypeT, MaxStates> result;
+    fixed_vector_t<StateTypeT, MaxStates> reached; // in the order they are taken from waiting
+    fixed_vector_t<std::size_t, MaxStates> parents;
+    reached.push_back(start);
+    parents.push_back(none);
+    for (std::size_t next = 0; next < reached.size(); ++next) {
+        if (isGoalState(reached[next])) {
+            fixed_vector_t<std::size_t, MaxStates> path;
+            for (auto index = next; index != none; index = parents[index]) {
+                path.push_back(index);
+            }
+            for (; !path.empty(); path.pop_back()) {
+                result.trace.push_back(reached[path.back()]);
+            }
+            result.complete = true;
+            return result;
+        }
+        fixed_vector_t<StateTypeT, MaxSuccessors> generated;
+        successors(reached[next], generated);
+        if (generated.overflowed()) {
+            return result;
+        }
+        for (const auto &successor: generated) {
+            if (!isValid(successor)) {
+                continue;
+            }
+            auto known = false;
+            for (std::size_t index = 0; index < reached.size() && !known; ++index) {
+                known = constexpr_equal(reached[index], successor);
+            }
+            if (!known) {
+                reached.push_back(successor);
+                parents.push_back(next);
+                if (reached.overflowed()) {
+                    return result;
+                }
+            }
+        }
+    }
+    result.complete = true;
+    return result;
+}
+
+#endif //PUZZLEENGINE_CONSTEXPR_SEARCH_HPP
@@ -4,76 +4,15 @@
  * Compile and run:
  * g++ -std=c++17 -pedantic -Wall -DNDEBUG -O3 -o crossing crossing.cpp && ./crossing
  */
-#include "reachability.hpp" // your header-only library solution
-
-#include <functional> // std::function
-#include <list>
-#include <array>
-#include <iostream>
-
-enum actor_t { cabbage, goat, wolf }; // names of the actors
-enum class pos_t { shore1, travel, shore2}; // names of the actor positions
-using actors_t = std::array<pos_t,3>; // positions of the actors
-
-auto transitions(const actors_t& actors) {
-	auto res = std::list<std::function<void(actors_t&)>>{};
-	for (auto i=0u; i<actors.size(); ++i)
-		switch(actors[i]) {
-		case pos_t::shore1:
-			res.push_back([i](actors_t& actors){ actors[i] = pos_t::travel; });
-			break;
-		case pos_t::travel:
-			res.push_back([i](actors_t& actors){ actors[i] = pos_t::shore1; });
-			res.push_back([i](actors_t& actors){ actors[i] = pos_t::shore2; });
-			break;
-		case pos_t::shore2:
-			res.push_back([i](actors_t& actors){ actors[i] = pos_t::travel; });
-			break;
-		}
-	return res;
-}
-
-bool is_valid(const actors_t& actors) {
-	// only one passenger:
-	if (std::count(std::begin(actors), std::end(actors), pos_t::travel)>1)
-		return false;
-	// goat cannot be left alone with wolf, as wolf will eat the goat:
-	if (actors[actor_t::goat]==actors[actor_t::wolf] && actors[actor_t::cabbage]==pos_t::travel)
-		return false;
-	// goat cannot be left alone with cabbage, as goat will eat the cabbage:
-	if (actors[actor_t::goat]==actors[actor_t::cabbage] && actors[actor_t::wolf]==pos_t::travel)
-		return false;
-	return true;
-}
-
-std::ostream& operator<<(std::ostream& os, const pos_t& pos) {
-	switch(pos) {
-	case pos_t::shore1: os << "1"; break;
-	case pos_t::travel: os << "~"; break;
-	case pos_t::shore2: os << "2"; break;
-	default: os << "?"; break; // something went terribly wrong
-	}
-	return os;
-}
-
-std::ostream& operator<<(std::ostream& os, const actors_t& actors) {
-	return os << actors[actor_t::cabbage]
-			  << actors[actor_t::goat]
-			  << actors[actor_t::wolf];
-}
-
-std::ostream& operator<<(std::ostream& os, std::list<const actors_t*>& trace) {
-	auto step = 0u;
-	for (auto* actors: trace)
-		os << step++ << ": " << *actors << '\n';
-	return os;
-}
+#include "crossing.hpp" // the puzzle model
 
 void solve(){
 	auto state_space = state_space_t<actors_t>(
 		actors_t{},                        // initial state
 		successors<actors_t>(transitions), // successor generator
 		&is_valid);                        // invariant over all states
+	state_space.set_batch_invariant(&is_valid_batch); // the same invariant a block of states at a time
+	state_space.set_frontier_layout(column_arrays);   // keep the waiting states in column arrays
 	auto solution = state_space.check(
 		[](const actors_t& actors){ // all actors should be on the shore2:
 			return std::count(std::begin(actors), std::end(actors), pos_t::shore2)==actors.size();
@@ -85,8 +24,44 @@ void solve(){
 		std::cout << it << ": " << trace << std::endl;
 }
 
+/** the same puzzle over the compiled tables, solved for every start state with all actors on the shores */
+void solve_compiled(){
+	auto state_space = state_space_t<actors_t>(actors_t{}, successors<actors_t>(transitions), &is_valid);
+	const auto compiled = state_space.compile();
+	auto all_shore2 = [](const actors_t& actors){
+		return std::count(std::begin(actors), std::end(actors), pos_t::shore2)==static_cast<long>(actors.size());
+	};
+	std::cout << "--- Compiled state space: ---" << std::endl;
+	std::cout << "start steps" << std::endl;
+	auto start = actors_t{};
+	for (auto rank = std::size_t{0}; rank < state_rank<actors_t>::count; ++rank) {
+		state_rank<actors_t>::unrank(rank, start);
+		if (std::count(std::begin(start), std::end(start), pos_t::travel)==0)
+			std::cout << start << "   " << static_cast<int>(compiled.check(start, all_shore2).size())-1 << std::endl;
+	}
+}
+
+constexpr bool all_on_shore2(const actors_t& actors){
+	return constexpr_equal(actors, actors_t{pos_t::shore2, pos_t::shore2, pos_t::shore2});
+}
+
+/** the solution found by the compiler: the whole space has 27 states, each with at most 6 successors */
+constexpr auto embedded_solution = constexpr_check<27, 6>(actors_t{}, &successor_states, &is_valid, &all_on_shore2);
+static_assert(embedded_solution.complete && embedded_solution.trace.size()==11, "the crossing takes ten steps");
+static_assert(all_on_shore2(embedded_solution.trace.back()), "the solution ends with all actors on shore2");
+
+void print_embedded(){
+	std::cout << "--- Solution embedded at compile time: ---" << std::endl;
+	std::cout << "#  CGW" << std::endl;
+	auto step = 0;
+	for (auto&& actors: embedded_solution.trace)
+		std::cout << step++ << ": " << actors << std::endl;
+}
+
 int main(){
 	solve();
+	solve_compiled();
+	print_embedded();
 }
 
 /** Sample output:
@@ -0,0 +1,161 @@
+/**
+ * Model of the river crossing puzzle with a goat, a cabbage and a wolf.
+ * Author: Marius Mikucionis <marius@cs.aau.dk>
+ */
+#ifndef PUZZLEENGINE_CROSSING_HPP
+#define PUZZLEENGINE_CROSSING_HPP
+
+#include "reachability.hpp" // your header-only library solution
+#include "constexpr_search.hpp"
+
+#include <functional> // std::function
+#include <list>
+#include <array>
+#include <iostream>
+
+enum actor_t { cabbage, goat, wolf }; // names of the actors
+enum class pos_t { shore1, travel, shore2}; // names of the actor positions
+using actors_t = std::array<pos_t,3>; // positions of the actors
+
+/** the rules of the puzzle: the positions an actor at each position can move to, from a shore into the boat and from
+ * the boat to either shore */
+struct crossing_moves_t {
+	std::size_t count;
+	pos_t to[2];
+};
+constexpr crossing_moves_t crossing_moves[] = {
+	{1, {pos_t::travel}},                // from shore1
+	{2, {pos_t::shore1, pos_t::shore2}}, // from travel
+	{1, {pos_t::travel}}};               // from shore2
+
+/** the states reached by moving each actor by the rules, for searches at compile time and for transitions */
+constexpr void successor_states(const actors_t& actors, fixed_vector_t<actors_t,6>& res) {
+	for (auto i=0u; i<actors.size(); ++i) {
+		auto& moves = crossing_moves[static_cast<std::size_t>(actors[i])];
+		for (auto m=0u; m<moves.count; ++m) {
+			auto next = actors;
+			next[i] = moves.to[m];
+			res.push_back(next);
+		}
+	}
+}
+
+/** the transitions lead to the successor_states, in the same order */
+inline auto transitions(const actors_t& actors) {
+	auto next = fixed_vector_t<actors_t,6>{};
+	successor_states(actors, next);
+	auto res = std::list<std::function<void(actors_t&)>>{};
+	for (auto& state: next)
+		res.push_back([state](actors_t& actors){ actors = state; });
+	return res;
+}
+
+/** tells whether the successor_states of actors are exactly the moves of the rules: one per move of each actor, in
+ * order, each changing only the moving actor */
+constexpr bool follows_moves(const actors_t& actors) {
+	auto next = fixed_vector_t<actors_t,6>{};
+	successor_states(actors, next);
+	auto k = std::size_t{0};
+	for (auto i=0u; i<actors.size(); ++i) {
+		auto& moves = crossing_moves[static_cast<std::size_t>(actors[i])];
+		for (auto m=0u; m<moves.count; ++m, ++k) {
+			if (k >= next.size() || next[k][i] != moves.to[m])
+				return false;
+			for (auto j=0u; j<actors.size(); ++j)
+				if (j != i && next[k][j] != actors[j])
+					return false;
+		}
+	}
+	return k == next.size() && !next.overflowed();
+}
+static_assert(follows_moves(actors_t{}), "the successors of the start state must follow the rules");
+
+constexpr bool is_valid(const actors_t& actors) {
+	// only one passenger (counted by hand, as std::count is not constexpr before C++20):
+	auto travelling = 0;
+	for (auto pos: actors)
+		travelling += pos==pos_t::travel;
+	if (travelling>1)
+		return false;
+	// goat cannot be left alone with wolf, as wolf will eat the goat:
+	if (actors[actor_t::goat]==actors[actor_t::wolf] && actors[actor_t::cabbage]==pos_t::travel)
+		return false;
+	// goat cannot be left alone with cabbage, as goat will eat the cabbage:
+	if (actors[actor_t::goat]==actors[actor_t::cabbage] && actors[actor_t::wolf]==pos_t::travel)
+		return false;
+	return true;
+}
+
+/** packs the actor positions into columns for batch predicates */
+template <>
+struct state_columns<actors_t> {
+	static constexpr bool supported = true;
+	using value_type = uint8_t;
+	static constexpr std::size_t count = 3;
+	static void pack(const actors_t& actors, value_type* row) {
+		for (auto i=0u; i<count; ++i)
+			row[i] = static_cast<value_type>(actors[i]);
+	}
+	static void unpack(const value_type* row, actors_t& actors) {
+		for (auto i=0u; i<count; ++i)
+			actors[i] = static_cast<pos_t>(row[i]);
+	}
+};
+
+/** numbers the actor positions as a base 3 number for compiled state spaces */
+template <>
+struct state_rank<actors_t> {
+	static constexpr bool supported = true;
+	static constexpr std::size_t count = 3*3*3;
+	static std::size_t rank(const actors_t& actors) {
+		auto res = std::size_t{0};
+		for (auto pos: actors)
+			res = res*3 + static_cast<std::size_t>(pos);
+		return res;
+	}
+	static void unrank(std::size_t rank, actors_t& actors) {
+		for (auto i=actors.size(); i-->0; rank /= 3)
+			actors[i] = static_cast<pos_t>(rank % 3);
+	}
+};
+
+/** is_valid over a block of states: the same checks as flags per lane without branching */
+inline uint64_t is_valid_batch(const soa_block_t<actors_t>& block) {
+	constexpr auto travel = static_cast<uint8_t>(pos_t::travel);
+	auto& cabbage_pos = block.columns[actor_t::cabbage];
+	auto& goat_pos = block.columns[actor_t::goat];
+	auto& wolf_pos = block.columns[actor_t::wolf];
+	auto valid = std::array<uint8_t, soa_block_t<actors_t>::lanes>{};
+	for (auto lane=0u; lane<block.size; ++lane) {
+		auto travelling = (cabbage_pos[lane]==travel) + (goat_pos[lane]==travel) + (wolf_pos[lane]==travel);
+		auto goat_eaten = (goat_pos[lane]==wolf_pos[lane]) & (cabbage_pos[lane]==travel);
+		auto cabbage_eaten = (goat_pos[lane]==cabbage_pos[lane]) & (wolf_pos[lane]==travel);
+		valid[lane] = (travelling<=1) & !goat_eaten & !cabbage_eaten;
+	}
+	return lane_mask(valid, block.size);
+}
+
+inline std::ostream& operator<<(std::ostream& os, const pos_t& pos) {
+	switch(pos) {
+	case pos_t::shore1: os << "1"; break;
+	case pos_t::travel: os << "~"; break;
+	case pos_t::shore2: os << "2"; break;
+	default: os << "?"; break; // something went terribly wrong
+	}
+	return os;
+}
+
+inline std::ostream& operator<<(std::ostream& os, const actors_t& actors) {
+	return os << actors[actor_t::cabbage]
+			  << actors[actor_t::goat]
+			  << actors[actor_t::wolf];
+}
+
+inline std::ostream& operator<<(std::ostream& os, std::list<const actors_t*>& trace) {
+	auto step = 0u;
+	for (auto* actors: trace)
+		os << step++ << ": " << *actors << '\n';
+	return os;
+}
+
+#endif //PUZZLEENGINE_CROSSING_HPP
@@ -0,0 +1,271 @@
+/**
+ * A timeline of the searches in the Chrome trace event format, which chrome://tracing and Perfetto load. Tracing is
+ * off until start_event_trace() is called. While it is on, the searches record spans for check(), every breadth first
+ * level, batches of expansions, the rebucketing of radix heaps and the rehashing of visited sets. Each thread records
+ * into a ring buffer of its own without locking, which keeps the latest events once it is full, and
+ * write_event_trace() writes the events of all threads as one JSON file with a track per thread. Starting, stopping
+ * and writing the trace must not overlap with searches that record events, e.g. they are called before the searches
+ * are started and after they are joined.
+ */
+
+#ifndef PUZZLEENGINE_EVENT_TRACE_HPP
+#define PUZZLEENGINE_EVENT_TRACE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// A completed span. The names are string literals, which are written to the JSON as they are.
+struct trace_event_t {
+    const char *category;
+    const char *name;
+    const char *argument; // the name of value, or null when the span has no argument
+    std::uint64_t value;
+    std::uint64_t start;    // nanoseconds since the trace was started
+    std::uint64_t duration; // nanoseconds
+};
+
+// The events of one thread. Only that thread records into it, so the count is the only state shared with the writer.
+class trace_ring_t {
+public:
+    trace_ring_t(std::size_t thread, std::size_t capacity) : _thread(thread), _events(capacity) {
+    }
+
+    void record(const trace_event_t &event) {
+        _events[_recorded % _events.size()] = event;
+        ++_recorded;
+    }
+
+    void clear() {
+        _recorded = 0;
+    }
+
+    std::size_t thread() const {
+        return _thread;
+    }
+
+    // The events that were overwritten by later ones.
+    std::size_t dropped() const {
+        return _recorded > _events.size() ? _recorded - _events.size() : 0;
+    }
+
+    // Calls fn with the kept events from the oldest to the latest.
+    template<class FunctionT>
+    void for_each(FunctionT fn) const {
+        for (auto index = dropped(); index < _recorded; ++index) {
+            fn(_events[index % _events.size()]);
+        }
+    }
+
+private:
+    std::size_t _thread;
+    std::vector<trace_event_t> _events;
+    std::size_t _recorded{0};
+};
+
+// The rings of all threads that recorded events, and whether tracing is on.
+class event_tracer_t {
+public:
+    static event_tracer_t &instance() {
+        static event_tracer_t tracer;
+        return tracer;
+    }
+
+    bool enabled() const {
+        return _enabled.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t now() const {
+        const auto elapsed = std::chrono::steady_clock::now() - _epoch;
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+    // Clears the rings and starts a new trace. Rings created from now on keep capacity events each.
+    void start(std::size_t capacity) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (auto &ring: _rings) {
+            ring->clear();
+        }
+        _capacity = std::max<std::size_t>(capacity, 1);
+        _epoch = std::chrono::steady_clock::now();
+        _enabled.store(true, std::memory_order_relaxed);
+    }
+
+    void stop() {
+        _enabled.store(false, std::memory_order_relaxed);
+    }
+
+    // The ring of the calling thread, which is created when the thread records its first event. The rings outlive
+    // their threads, so the events of a finished thread are still written.
+    trace_ring_t &ring() {
+        thread_local std::shared_ptr<trace_ring_t> ring;
+        if (!ring) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            ring = std::make_shared<trace_ring_t>(_rings.size(), _capacity);
+            _rings.push_back(ring);
+        }
+        return *ring;
+    }
+
+    void write(std::ostream &os) const {
+        std::lock_guard<std::mutex> lock(_mutex);
+        os << "{\"traceEvents\":[";
+        auto separator = "\n";
+        for (auto &ring: _rings) {
+            os << separator << R"({"ph":"M","name":"thread_name","pid":1,"tid":)" << ring->thread()
+               << R"(,"args":{"name":"search thread )" << ring->thread();
+            if (ring->dropped() != 0) {
+                os << " (" << ring->dropped() << " earlier events dropped)";
+            }
+            os << "\"}}";
+            separator = ",\n";
+            ring->for_each([&](const trace_event_t &event) {
+                os << ",\n" << R"({"ph":"X","cat":")" << event.category << R"(","name":")" << event.name
+                   << R"(","pid":1,"tid":)" << ring->thread() << R"(,"ts":)";
+                writeMicroseconds(os, event.start);
+                os << R"(,"dur":)";
+                writeMicroseconds(os, event.duration);
+                if (event.argument != nullptr) {
+                    os << R"(,"args":{")" << event.argument << "\":" << event.value << '}';
+                }
+                os << '}';
+            });
+        }
+        os << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    }
+
+    event_tracer_t(const event_tracer_t &) = delete;
+
+    event_tracer_t &operator=(const event_tracer_t &) = delete;
+
+private:
+    std::atomic<bool> _enabled{false};
+    std::chrono::steady_clock::time_point _epoch{std::chrono::steady_clock::now()};
+    std::size_t _capacity{0};
+    mutable std::mutex _mutex; // guards the list of rings and the capacity
+    std::vector<std::shared_ptr<trace_ring_t>> _rings;
+
+    event_tracer_t() = default;
+
+    // The trace format counts in microseconds, so nanoseconds are written with three decimals.
+    static void writeMicroseconds(std::ostream &os, std::uint64_t nanoseconds) {
+        const auto fraction = nanoseconds % 1000;
+        os << nanoseconds / 1000 << '.' << fraction / 100 << fraction / 10 % 10 << fraction % 10;
+    }
+};
+
+// Starts recording the events of the searches into rings of capacity events per thread, dropping any earlier trace.
+inline void start_event_trace(std::size_t capacity = 1u << 16) {
+    event_tracer_t::instance().start(capacity);
+}
+
+// Stops recording. The events recorded so far are kept until the next start.
+inline void stop_event_trace() {
+    event_tracer_t::instance().stop();
+}
+
+inline void write_event_trace(std::ostream &os) {
+    event_tracer_t::instance().write(os);
+}
+
+// Writes the trace to the file at path. Returns false if it could not be written.
+inline bool write_event_trace(const std::string &path) {
+    std::ofstream out(path);
+    write_event_trace(out);
+    return static_cast<bool>(out);
+}
+
+// Records a span from begin() to end() or the destruction, provided tracing was on when it began. A span that is begun
+// again ends the previous one first, so one object can record consecutive spans like the levels of a search.
+class trace_span_t {
+public:
+    trace_span_t() = default;
+
+    trace_span_t(const char *category, const char *name, const char *argument = nullptr, std::uint64_t value = 0) {
+        begin(category, name, argument, value);
+    }
+
+    trace_span_t(const trace_span_t &) = delete;
+
+    trace_span_t &operator=(const trace_span_t &) = delete;
+
+    ~trace_span_t() {
+        end();
+    }
+
+    void begin(const char *category, const char *name, const char *argument = nullptr, std::uint64_t value = 0) {
+        end();
+        auto &tracer = event_tracer_t::instance();
+        if (tracer.enabled()) {
+            _event = trace_event_t{category, name, argument, value, tracer.now(), 0};
+            _active = true;
+        }
+    }
+
+    // Replaces the value of the argument, e.g. with a count that is only known at the end.
+    void set_value(std::uint64_t value) {
+        _event.value = value;
+    }
+
+    void end() {
+        if (_active) {
+            auto &tracer = event_tracer_t::instance();
+            _event.duration = tracer.now() - _event.start;
+            tracer.ring().record(_event);
+            _active = false;
+        }
+    }
+
+private:
+    trace_event_t _event{};
+    bool _active{false};
+};
+
+// Records the expansions of a search as spans of up to batch_size expansions, so the overhead does not grow with the
+// number of expansions. expanded() is called before each expansion. cut() ends the current batch early, e.g. at the
+// end of a breadth first level, so the batches nest within the levels.
+class expansion_trace_t {
+public:
+    static constexpr std::size_t batch_size = 4096;
+
+    expansion_trace_t() = default;
+
+    expansion_trace_t(const expansion_trace_t &) = delete;
+
+    expansion_trace_t &operator=(const expansion_trace_t &) = delete;
+
+    ~expansion_trace_t() {
+        cut();
+    }
+
+    void expanded() {
+        if (_count == batch_size) {
+            cut();
+        }
+        if (_count++ == 0) {
+            _batch.begin("search", "expansions", "expanded");
+        }
+    }
+
+    void cut() {
+        if (_count != 0) {
+            _batch.set_value(_count);
+            _batch.end();
+            _count = 0;
+        }
+    }
+
+private:
+    trace_span_t _batch;
+    std::size_t _count{0};
+};
+
+#endif //PUZZLEENGINE_EVENT_TRACE_HPP
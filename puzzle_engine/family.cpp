@@ -8,322 +8,18 @@
  * ./family | grep trv | grep '~~~'
  */
 
-#include "reachability.hpp" // your header-only library solution
-
-#include <iostream>
-#include <vector>
-#include <list>
-#include <array>
-#include <functional> // std::function
-#include <algorithm>  // all_of
-
-/** Model of the river crossing: persons and a boat */
-struct person_t {
-	enum { shore1, onboard, shore2 } pos = shore1;
-	enum { mother, father, daughter1, daughter2, son1, son2, policeman, prisoner };
-};
-
-struct boat_t {
-	enum { shore1, travel, shore2 } pos = shore1;
-	uint16_t capacity{2};
-	uint16_t passengers{0};
-};
-struct state_t {
-	boat_t boat;
-	std::array<person_t,8> persons;
-};
-
-/** less-than operators for std::map */
-bool operator<(const person_t& p1, const person_t& p2) {
-	if (p1.pos < p2.pos)
-		return true;
-	else if (p2.pos < p1.pos)
-		return false; // p2 < p1
-	return false; // equal
-}
-
-bool operator<(const boat_t& b1, const boat_t& b2) {
-	if (b1.pos < b2.pos)
-		return true;
-	else if (b2.pos < b1.pos)
-		return false;
-	if (b1.passengers < b2.passengers)
-		return true;
-	else if (b2.passengers < b1.passengers)
-		return false;
-	if (b1.capacity < b2.capacity)
-		return true;
-	else if (b2.capacity < b1.capacity)
-		return false;
-	return false;
-}
-
-bool operator<(const state_t& s1, const state_t& s2) {
-	if (s1.boat < s2.boat)
-		return true;
-	if (s2.boat < s1.boat)
-		return false; // s2 < s1
-	for (auto i=0u; i<s1.persons.size(); ++i)
-		if (s1.persons[i] < s2.persons[i])
-			return true;
-		else if (s2.persons[i] < s1.persons[i])
-			return false;
-	return false; // s2 == s1
-}
-
-/** equality operations for std::unordered_map */
-bool operator==(const person_t& p1, const person_t& p2) {
-	return (p1.pos == p2.pos);
-}
-
-bool operator==(const boat_t& b1, const boat_t& b2) {
-	return (b1.pos == b2.pos) &&
-		(b1.capacity == b2.capacity) &&
-		(b1.passengers == b2.passengers);
-}
-
-bool operator==(const state_t& s1, const state_t& s2) {
-	return (s1.boat == s2.boat) && (s1.persons == s2.persons);
-}
-
-/** hash operations for std::unordered_map */
-namespace std {
-	template <>
-	struct hash<person_t> {
-		std::size_t operator()(const person_t& key) const {
-			return std::hash<decltype(key.pos)>{}(key.pos);
-		}
-	};
-	template <>
-	struct hash<boat_t> {
-		std::size_t operator()(const boat_t& key) const {
-			auto h_pos = std::hash<decltype(key.pos)>{};
-			auto h_int = std::hash<decltype(key.capacity)>{};
-			return ((((h_pos(key.pos) << 1) ^
-					  h_int(key.capacity)) << 1) ^
-					h_int(key.passengers));
-		}
-	};
-
-	template <>
-	struct hash<state_t> {
-		std::size_t operator()(const state_t& key) const {
-			return (std::hash<boat_t>{}(key.boat) << 1) ^
-				std::hash<decltype(key.persons)>{}(key.persons); // assumes hash over container
-		}
-	};
-}
-
-std::ostream& operator<<(std::ostream& os, const person_t& p) {
-	os << '{';
-	switch (p.pos) {
-	case person_t::shore1: os << "sh1"; break;
-	case person_t::onboard: os << "~~~"; break;
-	case person_t::shore2: os << "SH2"; break;
-	default: os << "???" ; break; // something went terribly wrong
-	}
-	return os << '}';
-}
-
-std::ostream& operator<<(std::ostream& os, const boat_t& b) {
-	os << '{';
-	switch (b.pos) {
-	case boat_t::shore1: os << "sh1"; break;
-	case boat_t::travel: os << "trv"; break;
-	case boat_t::shore2: os << "SH2"; break;
-	default: os << "???" ; break; // something went terribly wrong
-	}
-	return os << ',' << b.passengers << ',' << b.capacity << '}';
-}
-
-
-std::ostream& operator<<(std::ostream& os, const state_t& s){
-	return os << s.boat << ','
-			  << s.persons[person_t::mother] << ','
-			  << s.persons[person_t::father] << ','
-			  << s.persons[person_t::daughter1] << ','
-			  << s.persons[person_t::daughter2] << ','
-			  << s.persons[person_t::son1] << ','
-			  << s.persons[person_t::son2] << ','
-			  << s.persons[person_t::policeman] << ','
-			  << s.persons[person_t::prisoner];
-}
-
-/**
- * Returns a list of transitions applicable on a given state.
- * transition is a function modifying a state
- */
-std::list<std::function<void(state_t&)>>
-transitions(const state_t& s) {
-	auto res = std::list<std::function<void(state_t&)>>{};
-	switch (s.boat.pos) {
-	case boat_t::shore1:
-	case boat_t::shore2:
-		if (s.boat.passengers>0) // start traveling
-			res.push_back([](state_t& state){ state.boat.pos = boat_t::travel; });
-		break;
-	case boat_t::travel:
-		res.emplace_back([](state_t& state){ // arrive to shore1
-							 state.boat.pos = boat_t::shore1;
-							 state.boat.passengers = 0;
-							 for (auto& p: state.persons)
-								 if (p.pos == person_t::onboard)
-									 p.pos = person_t::shore1;
-						 });
-		res.emplace_back([](state_t& state){	// arrive to shore2
-							 state.boat.pos = boat_t::shore2;
-							 state.boat.passengers = 0;
-							 for (auto& p: state.persons)
-								 if (p.pos == person_t::onboard)
-									 p.pos = person_t::shore2;
-						 });
-		break;
-	}
-	for (auto i=0u; i<s.persons.size(); ++i) {
-		switch (s.persons[i].pos) {
-		case person_t::shore1:  // board the boat on shore1:
-			if (s.boat.pos == boat_t::shore1)
-				res.push_back([i](state_t& state){
-								  state.persons[i].pos = person_t::onboard;
-								  state.boat.passengers++;
-							  });
-			break;
-		case person_t::shore2: // board the boat on shore2:
-			if (s.boat.pos == boat_t::shore2)
-				res.push_back([i](state_t& state){
-								  state.persons[i].pos = person_t::onboard;
-								  state.boat.passengers++;
-							  });
-			break;
-		case person_t::onboard:
-			if (s.boat.pos == boat_t::shore1) // leave the boat to shore1
-				res.push_back([i](state_t& state){
-								  state.persons[i].pos = person_t::shore1;
-								  state.boat.passengers--;
-							  });
-			else if (s.boat.pos == boat_t::shore2) // leave the boat to shore2
-				res.push_back([i](state_t& state){
-								  state.persons[i].pos = person_t::shore2;
-								  state.boat.passengers--;
-							  });
-			break;
-		}
-	}
-	return res;
-}
-
-bool river_crossing_valid(const state_t& s) {
-	if (s.boat.passengers > s.boat.capacity) {
-//		log(" boat overload\n");
-		return false;
-	}
-	if (s.boat.pos == boat_t::travel) {
-		if (s.persons[person_t::daughter1].pos == person_t::onboard) {
-			if (s.boat.passengers==1 ||
-				(s.persons[person_t::daughter2].pos == person_t::onboard) ||
-				(s.persons[person_t::son1].pos == person_t::onboard) ||
-				(s.persons[person_t::son2].pos == person_t::onboard) ||
-				(s.persons[person_t::prisoner].pos == person_t::onboard)) {
-//				log(" d1 travel alone\n");
-				return false;
-			}
-		} else if (s.persons[person_t::daughter2].pos == person_t::onboard) {
-			if (s.boat.passengers==1 ||
-				(s.persons[person_t::daughter1].pos == person_t::onboard) ||
-				(s.persons[person_t::son1].pos == person_t::onboard) ||
-				(s.persons[person_t::son2].pos == person_t::onboard) ||
-				(s.persons[person_t::prisoner].pos == person_t::onboard)) {
-//				log(" d2 travel alone\n");
-				return false;
-			}
-		} else if (s.persons[person_t::son1].pos == person_t::onboard) {
-			if (s.boat.passengers==1 ||
-				(s.persons[person_t::daughter1].pos == person_t::onboard) ||
-				(s.persons[person_t::daughter2].pos == person_t::onboard) ||
-				(s.persons[person_t::son2].pos == person_t::onboard) ||
-				(s.persons[person_t::prisoner].pos == person_t::onboard)) {
-//				log(" s1 travel alone\n");
-				return false;
-			}
-		} else if (s.persons[person_t::son2].pos == person_t::onboard) {
-			if (s.boat.passengers==1 ||
-				(s.persons[person_t::daughter1].pos == person_t::onboard) ||
-				(s.persons[person_t::daughter2].pos == person_t::onboard) ||
-				(s.persons[person_t::son1].pos == person_t::onboard) ||
-				(s.persons[person_t::prisoner].pos == person_t::onboard)) {
-//				log(" s2 travel alone\n");
-				return false;
-			}
-		}
-		if (s.persons[person_t::prisoner].pos != s.persons[person_t::policeman].pos) {
-			auto prisoner_pos = s.persons[person_t::prisoner].pos;
-			if ((s.persons[person_t::daughter1].pos == prisoner_pos) ||
-				(s.persons[person_t::daughter2].pos == prisoner_pos) ||
-				(s.persons[person_t::son1].pos == prisoner_pos) ||
-				(s.persons[person_t::son2].pos == prisoner_pos) ||
-				(s.persons[person_t::mother].pos == prisoner_pos) ||
-				(s.persons[person_t::father].pos == prisoner_pos)) {
-//				log(" pr with family\n");
-				return false;
-			}
-		}
-		if (s.persons[person_t::prisoner].pos == person_t::onboard && s.boat.passengers<2) {
-//			log(" pr on boat\n");
-			return false;
-		}
-	}
-	if ((s.persons[person_t::daughter1].pos == s.persons[person_t::father].pos) &&
-		(s.persons[person_t::daughter1].pos != s.persons[person_t::mother].pos)) {
-//		log(" d1 with f\n");
-		return false;
-	} else if ((s.persons[person_t::daughter2].pos == s.persons[person_t::father].pos) &&
-			   (s.persons[person_t::daughter2].pos != s.persons[person_t::mother].pos)) {
-//		log(" d2 with f\n");
-		return false;
-	} else if ((s.persons[person_t::son1].pos == s.persons[person_t::mother].pos) &&
-			   (s.persons[person_t::son1].pos != s.persons[person_t::father].pos)) {
-//		log(" s1 with m\n");
-		return false;
-	} else if ((s.persons[person_t::son2].pos == s.persons[person_t::mother].pos) &&
-			   (s.persons[person_t::son2].pos != s.persons[person_t::father].pos)) {
-//		log(" s2 with m\n");
-		return false;
-	}
-//	log(" OK\n");
-	return true;
-}
-
-struct cost_t {
-	size_t depth{0}; // counts the number of transitions
-	size_t noise{0}; // kids get bored on shore1 and start making noise there
-	bool operator<(const cost_t& other) const {
-		if (depth < other.depth)
-			return true;
-		if (other.depth < depth)
-			return false;
-		return noise < other.noise;
-	}
-};
-
-bool goal(const state_t& s){
-	return std::all_of(std::begin(s.persons), std::end(s.persons),
-					   [](const person_t& p) { return p.pos == person_t::shore2; });
-}
-
+#include "family.hpp" // the puzzle model
 
 template <typename CostFn>
-void solve(CostFn&& cost) { // no type checking: OK hack here, but not good for a library.
+void solve(state_space_t<state_t, cost_t>& states,
+		   CostFn&& cost) { // no type checking: OK hack here, but not good for a library.
 	// Overall there are 4*3*2*1/2 solutions to the puzzle
 	// (children form 2 symmetric groups and thus result in 2 out of 4 permutations).
 	// However the search algorithm may collapse symmetric solutions, thus only one is reported.
 	// By changing the cost function we can express a preference and
 	// then the algorithm should report different solutions
-	auto states = state_space_t<state_t, cost_t>{
-		state_t{}, cost_t{},              // initial state and cost
-		successors<state_t>(transitions), // successor generator
-		&river_crossing_valid,            // invariant over states
-		std::forward<CostFn>(cost)};      // cost over states
-	auto solutions = states.check(&goal);
+	states.set_cost(std::forward<CostFn>(cost)); // cost over states
+	auto solutions = states.check(&goal_batch); // goal checked on blocks of states too
 	if (solutions.empty()) {
 		std::cout << "No solution\n";
 	} else {
@@ -336,13 +32,34 @@ void solve(CostFn&& cost) { // no type checking: OK hack here, but not good for
 	}
 }
 
+/** the depth search without the graph cache, keeping the passed states and the trace nodes collapsed */
+void solve_collapsed() {
+	auto states = state_space_t<state_t, cost_t>{
+		state_t{}, cost_t{}, successors<state_t>(transitions), &river_crossing_valid};
+	states.set_batch_invariant(&river_crossing_valid_batch);
+	states.set_visited_layout(collapsed_states); // states as indices of interned parts
+	states.set_cost([](const state_t&, const cost_t& prev_cost){
+		return cost_t{ prev_cost.depth+1, prev_cost.noise };
+	});
+	auto solutions = states.check(&goal_batch);
+	std::cout << "Trace of " << solutions.size() << " states, " << states.statistics().expanded
+			  << " states expanded\n";
+}
+
 int main() {
+	// one state space for all costs: its graph is explored by the first search and reused by the others
+	auto states = state_space_t<state_t, cost_t>{
+		state_t{}, cost_t{},              // initial state and cost
+		successors<state_t>(transitions), // successor generator
+		&river_crossing_valid};           // invariant over states
+	states.set_batch_invariant(&river_crossing_valid_batch); // the same invariant a block of states at a time
+	states.enable_graph_cache();                             // later costs are searched on the cached graph
 	std::cout << "-- Solve using depth as a cost: ---\n";
-	solve([](const state_t& state, const cost_t& prev_cost){
+	solve(states, [](const state_t& state, const cost_t& prev_cost){
 			  return cost_t{ prev_cost.depth+1, prev_cost.noise };
 		  }); // it is likely that daughters will get to shore2 first
 	std::cout << "-- Solve using noise as a cost: ---\n";
-	solve([](const state_t& state, const cost_t& prev_cost){
+	solve(states, [](const state_t& state, const cost_t& prev_cost){
 			  auto noise = prev_cost.noise;
 			  if (state.persons[person_t::son1].pos == person_t::shore1)
 				  noise += 2; // older son is more noughty, prefer him first
@@ -351,7 +68,7 @@ int main() {
 			  return cost_t{ prev_cost.depth, noise };
 		  }); // son1 should get to shore2 first
 	std::cout << "-- Solve using different noise as a cost: ---\n";
-	solve([](const state_t& state, const cost_t& prev_cost){
+	solve(states, [](const state_t& state, const cost_t& prev_cost){
 			  auto noise = prev_cost.noise;
 			  if (state.persons[person_t::son1].pos == person_t::shore1)
 				  noise += 1;
@@ -359,6 +76,8 @@ int main() {
 				  noise += 2; // younger son is more distressed, prefer him first
 			  return cost_t{ prev_cost.depth, noise };
 		  }); // son2 should get to the shore2 first
+	std::cout << "-- Solve using depth as a cost on collapsed states: ---\n";
+	solve_collapsed();
 }
 /** Example solutions (shows only the states with travel):
 --- Solve using depth as a cost: ---
@@ -0,0 +1,411 @@
+/**
+ * Model of the family river crossing puzzle with a policeman and a prisoner.
+ * Author: Marius Mikucionis <marius@cs.aau.dk>
+ */
+#ifndef PUZZLEENGINE_FAMILY_HPP
+#define PUZZLEENGINE_FAMILY_HPP
+
+#include "reachability.hpp" // your header-only library solution
+
+#include <iostream>
+#include <vector>
+#include <list>
+#include <array>
+#include <functional> // std::function
+#include <algorithm>  // all_of
+#include <cstddef>    // offsetof
+
+/** Model of the river crossing: persons and a boat */
+struct person_t {
+	enum { shore1, onboard, shore2 } pos = shore1;
+	enum { mother, father, daughter1, daughter2, son1, son2, policeman, prisoner };
+};
+
+struct boat_t {
+	enum { shore1, travel, shore2 } pos = shore1;
+	uint16_t capacity{2};
+	uint16_t passengers{0};
+};
+struct state_t {
+	boat_t boat;
+	std::array<person_t,8> persons;
+};
+
+/** less-than operators for std::map */
+inline bool operator<(const person_t& p1, const person_t& p2) {
+	if (p1.pos < p2.pos)
+		return true;
+	else if (p2.pos < p1.pos)
+		return false; // p2 < p1
+	return false; // equal
+}
+
+inline bool operator<(const boat_t& b1, const boat_t& b2) {
+	if (b1.pos < b2.pos)
+		return true;
+	else if (b2.pos < b1.pos)
+		return false;
+	if (b1.passengers < b2.passengers)
+		return true;
+	else if (b2.passengers < b1.passengers)
+		return false;
+	if (b1.capacity < b2.capacity)
+		return true;
+	else if (b2.capacity < b1.capacity)
+		return false;
+	return false;
+}
+
+inline bool operator<(const state_t& s1, const state_t& s2) {
+	if (s1.boat < s2.boat)
+		return true;
+	if (s2.boat < s1.boat)
+		return false; // s2 < s1
+	for (auto i=0u; i<s1.persons.size(); ++i)
+		if (s1.persons[i] < s2.persons[i])
+			return true;
+		else if (s2.persons[i] < s1.persons[i])
+			return false;
+	return false; // s2 == s1
+}
+
+/** equality operations for std::unordered_map */
+inline bool operator==(const person_t& p1, const person_t& p2) {
+	return (p1.pos == p2.pos);
+}
+
+inline bool operator==(const boat_t& b1, const boat_t& b2) {
+	return (b1.pos == b2.pos) &&
+		(b1.capacity == b2.capacity) &&
+		(b1.passengers == b2.passengers);
+}
+
+inline bool operator==(const state_t& s1, const state_t& s2) {
+	return (s1.boat == s2.boat) && (s1.persons == s2.persons);
+}
+
+/** hash operations for std::unordered_map */
+namespace std {
+	template <>
+	struct hash<person_t> {
+		std::size_t operator()(const person_t& key) const {
+			return std::hash<decltype(key.pos)>{}(key.pos);
+		}
+	};
+	template <>
+	struct hash<boat_t> {
+		std::size_t operator()(const boat_t& key) const {
+			auto h_pos = std::hash<decltype(key.pos)>{};
+			auto h_int = std::hash<decltype(key.capacity)>{};
+			return hash_combine(hash_combine(h_pos(key.pos), h_int(key.capacity)),
+								h_int(key.passengers));
+		}
+	};
+
+	template <>
+	struct hash<state_t> {
+		std::size_t operator()(const state_t& key) const {
+			return hash_combine(std::hash<boat_t>{}(key.boat),
+								state_hash<decltype(key.persons)>{}(key.persons));
+		}
+	};
+}
+
+inline std::ostream& operator<<(std::ostream& os, const person_t& p) {
+	os << '{';
+	switch (p.pos) {
+	case person_t::shore1: os << "sh1"; break;
+	case person_t::onboard: os << "~~~"; break;
+	case person_t::shore2: os << "SH2"; break;
+	default: os << "???" ; break; // something went terribly wrong
+	}
+	return os << '}';
+}
+
+inline std::ostream& operator<<(std::ostream& os, const boat_t& b) {
+	os << '{';
+	switch (b.pos) {
+	case boat_t::shore1: os << "sh1"; break;
+	case boat_t::travel: os << "trv"; break;
+	case boat_t::shore2: os << "SH2"; break;
+	default: os << "???" ; break; // something went terribly wrong
+	}
+	return os << ',' << b.passengers << ',' << b.capacity << '}';
+}
+
+
+inline std::ostream& operator<<(std::ostream& os, const state_t& s){
+	return os << s.boat << ','
+			  << s.persons[person_t::mother] << ','
+			  << s.persons[person_t::father] << ','
+			  << s.persons[person_t::daughter1] << ','
+			  << s.persons[person_t::daughter2] << ','
+			  << s.persons[person_t::son1] << ','
+			  << s.persons[person_t::son2] << ','
+			  << s.persons[person_t::policeman] << ','
+			  << s.persons[person_t::prisoner];
+}
+
+/**
+ * Returns a list of transitions applicable on a given state.
+ * transition is a function modifying a state
+ */
+inline std::list<std::function<void(state_t&)>>
+transitions(const state_t& s) {
+	auto res = std::list<std::function<void(state_t&)>>{};
+	switch (s.boat.pos) {
+	case boat_t::shore1:
+	case boat_t::shore2:
+		if (s.boat.passengers>0) // start traveling
+			res.push_back([](state_t& state){ state.boat.pos = boat_t::travel; });
+		break;
+	case boat_t::travel:
+		res.emplace_back([](state_t& state){ // arrive to shore1
+							 state.boat.pos = boat_t::shore1;
+							 state.boat.passengers = 0;
+							 for (auto& p: state.persons)
+								 if (p.pos == person_t::onboard)
+									 p.pos = person_t::shore1;
+						 });
+		res.emplace_back([](state_t& state){	// arrive to shore2
+							 state.boat.pos = boat_t::shore2;
+							 state.boat.passengers = 0;
+							 for (auto& p: state.persons)
+								 if (p.pos == person_t::onboard)
+									 p.pos = person_t::shore2;
+						 });
+		break;
+	}
+	for (auto i=0u; i<s.persons.size(); ++i) {
+		switch (s.persons[i].pos) {
+		case person_t::shore1:  // board the boat on shore1:
+			if (s.boat.pos == boat_t::shore1)
+				res.push_back([i](state_t& state){
+								  state.persons[i].pos = person_t::onboard;
+								  state.boat.passengers++;
+							  });
+			break;
+		case person_t::shore2: // board the boat on shore2:
+			if (s.boat.pos == boat_t::shore2)
+				res.push_back([i](state_t& state){
+								  state.persons[i].pos = person_t::onboard;
+								  state.boat.passengers++;
+							  });
+			break;
+		case person_t::onboard:
+			if (s.boat.pos == boat_t::shore1) // leave the boat to shore1
+				res.push_back([i](state_t& state){
+								  state.persons[i].pos = person_t::shore1;
+								  state.boat.passengers--;
+							  });
+			else if (s.boat.pos == boat_t::shore2) // leave the boat to shore2
+				res.push_back([i](state_t& state){
+								  state.persons[i].pos = person_t::shore2;
+								  state.boat.passengers--;
+							  });
+			break;
+		}
+	}
+	return res;
+}
+
+inline bool river_crossing_valid(const state_t& s) {
+	if (s.boat.passengers > s.boat.capacity) {
+//		log(" boat overload\n");
+		return false;
+	}
+	if (s.boat.pos == boat_t::travel) {
+		if (s.persons[person_t::daughter1].pos == person_t::onboard) {
+			if (s.boat.passengers==1 ||
+				(s.persons[person_t::daughter2].pos == person_t::onboard) ||
+				(s.persons[person_t::son1].pos == person_t::onboard) ||
+				(s.persons[person_t::son2].pos == person_t::onboard) ||
+				(s.persons[person_t::prisoner].pos == person_t::onboard)) {
+//				log(" d1 travel alone\n");
+				return false;
+			}
+		} else if (s.persons[person_t::daughter2].pos == person_t::onboard) {
+			if (s.boat.passengers==1 ||
+				(s.persons[person_t::daughter1].pos == person_t::onboard) ||
+				(s.persons[person_t::son1].pos == person_t::onboard) ||
+				(s.persons[person_t::son2].pos == person_t::onboard) ||
+				(s.persons[person_t::prisoner].pos == person_t::onboard)) {
+//				log(" d2 travel alone\n");
+				return false;
+			}
+		} else if (s.persons[person_t::son1].pos == person_t::onboard) {
+			if (s.boat.passengers==1 ||
+				(s.persons[person_t::daughter1].pos == person_t::onboard) ||
+				(s.persons[person_t::daughter2].pos == person_t::onboard) ||
+				(s.persons[person_t::son2].pos == person_t::onboard) ||
+				(s.persons[person_t::prisoner].pos == person_t::onboard)) {
+//				log(" s1 travel alone\n");
+				return false;
+			}
+		} else if (s.persons[person_t::son2].pos == person_t::onboard) {
+			if (s.boat.passengers==1 ||
+				(s.persons[person_t::daughter1].pos == person_t::onboard) ||
+				(s.persons[person_t::daughter2].pos == person_t::onboard) ||
+				(s.persons[person_t::son1].pos == person_t::onboard) ||
+				(s.persons[person_t::prisoner].pos == person_t::onboard)) {
+//				log(" s2 travel alone\n");
+				return false;
+			}
+		}
+		if (s.persons[person_t::prisoner].pos != s.persons[person_t::policeman].pos) {
+			auto prisoner_pos = s.persons[person_t::prisoner].pos;
+			if ((s.persons[person_t::daughter1].pos == prisoner_pos) ||
+				(s.persons[person_t::daughter2].pos == prisoner_pos) ||
+				(s.persons[person_t::son1].pos == prisoner_pos) ||
+				(s.persons[person_t::son2].pos == prisoner_pos) ||
+				(s.persons[person_t::mother].pos == prisoner_pos) ||
+				(s.persons[person_t::father].pos == prisoner_pos)) {
+//				log(" pr with family\n");
+				return false;
+			}
+		}
+		if (s.persons[person_t::prisoner].pos == person_t::onboard && s.boat.passengers<2) {
+//			log(" pr on boat\n");
+			return false;
+		}
+	}
+	if ((s.persons[person_t::daughter1].pos == s.persons[person_t::father].pos) &&
+		(s.persons[person_t::daughter1].pos != s.persons[person_t::mother].pos)) {
+//		log(" d1 with f\n");
+		return false;
+	} else if ((s.persons[person_t::daughter2].pos == s.persons[person_t::father].pos) &&
+			   (s.persons[person_t::daughter2].pos != s.persons[person_t::mother].pos)) {
+//		log(" d2 with f\n");
+		return false;
+	} else if ((s.persons[person_t::son1].pos == s.persons[person_t::mother].pos) &&
+			   (s.persons[person_t::son1].pos != s.persons[person_t::father].pos)) {
+//		log(" s1 with m\n");
+		return false;
+	} else if ((s.persons[person_t::son2].pos == s.persons[person_t::mother].pos) &&
+			   (s.persons[person_t::son2].pos != s.persons[person_t::father].pos)) {
+//		log(" s2 with m\n");
+		return false;
+	}
+//	log(" OK\n");
+	return true;
+}
+
+/** packs the boat and the person positions into columns for batch predicates */
+template <>
+struct state_columns<state_t> {
+	static constexpr bool supported = true;
+	using value_type = uint16_t;
+	enum { boat_pos, boat_capacity, boat_passengers, first_person };
+	static constexpr std::size_t count = first_person + 8;
+	static void pack(const state_t& s, value_type* row) {
+		row[boat_pos] = s.boat.pos;
+		row[boat_capacity] = s.boat.capacity;
+		row[boat_passengers] = s.boat.passengers;
+		for (auto i=0u; i<s.persons.size(); ++i)
+			row[first_person+i] = s.persons[i].pos;
+	}
+	static void unpack(const value_type* row, state_t& s) {
+		s.boat.pos = decltype(s.boat.pos)(row[boat_pos]);
+		s.boat.capacity = row[boat_capacity];
+		s.boat.passengers = row[boat_passengers];
+		for (auto i=0u; i<s.persons.size(); ++i)
+			s.persons[i].pos = decltype(s.persons[i].pos)(row[first_person+i]);
+	}
+};
+
+/** river_crossing_valid over a block of states: the same rules as flags per lane without branching */
+inline uint64_t river_crossing_valid_batch(const soa_block_t<state_t>& block) {
+	using columns = state_columns<state_t>;
+	auto& boat = block.columns[columns::boat_pos];
+	auto& capacity = block.columns[columns::boat_capacity];
+	auto& passengers = block.columns[columns::boat_passengers];
+	auto pos = [&block](int person) -> auto& { return block.columns[columns::first_person+person]; };
+	auto& mother = pos(person_t::mother);
+	auto& father = pos(person_t::father);
+	auto& daughter1 = pos(person_t::daughter1);
+	auto& daughter2 = pos(person_t::daughter2);
+	auto& son1 = pos(person_t::son1);
+	auto& son2 = pos(person_t::son2);
+	auto& policeman = pos(person_t::policeman);
+	auto& prisoner = pos(person_t::prisoner);
+	auto valid = std::array<uint8_t, soa_block_t<state_t>::lanes>{};
+	for (auto l=0u; l<block.size; ++l) {
+		int overload = passengers[l] > capacity[l];
+		int travel = boat[l] == boat_t::travel;
+		int alone = passengers[l] == 1;
+		int d1 = daughter1[l] == person_t::onboard, d2 = daughter2[l] == person_t::onboard;
+		int s1 = son1[l] == person_t::onboard, s2 = son2[l] == person_t::onboard;
+		int pr = prisoner[l] == person_t::onboard;
+		// the first child onboard must neither travel alone nor with another child or the prisoner:
+		int child =
+			(d1 & (alone | d2 | s1 | s2 | pr)) |
+			((d1^1) & d2 & (alone | s1 | s2 | pr)) |
+			((d1^1) & (d2^1) & s1 & (alone | s2 | pr)) |
+			((d1^1) & (d2^1) & (s1^1) & s2 & (alone | pr));
+		int with_family = (prisoner[l] != policeman[l]) &
+			((daughter1[l] == prisoner[l]) | (daughter2[l] == prisoner[l]) |
+			 (son1[l] == prisoner[l]) | (son2[l] == prisoner[l]) |
+			 (mother[l] == prisoner[l]) | (father[l] == prisoner[l]));
+		int prisoner_alone = pr & (passengers[l] < 2);
+		int parents =
+			((daughter1[l] == father[l]) & (daughter1[l] != mother[l])) |
+			((daughter2[l] == father[l]) & (daughter2[l] != mother[l])) |
+			((son1[l] == mother[l]) & (son1[l] != father[l])) |
+			((son2[l] == mother[l]) & (son2[l] != father[l]));
+		valid[l] = !overload & !(travel & (child | with_family | prisoner_alone)) & !parents;
+	}
+	return lane_mask(valid, block.size);
+}
+
+struct cost_t {
+	size_t depth{0}; // counts the number of transitions
+	size_t noise{0}; // kids get bored on shore1 and start making noise there
+	bool operator<(const cost_t& other) const {
+		if (depth < other.depth)
+			return true;
+		if (other.depth < depth)
+			return false;
+		return noise < other.noise;
+	}
+};
+
+/** cost decomposition for the bucket open list: compared by depth first, then by noise */
+template <>
+struct cost_decomposition<cost_t> {
+	static constexpr bool supported = true;
+	static constexpr std::size_t levels = 2;
+	static std::array<std::size_t, levels> decompose(const cost_t& cost) {
+		return {cost.depth, cost.noise};
+	}
+};
+
+/** collapse compression parts: the boat and the two halves of the persons */
+template <>
+struct collapse_layout<state_t> {
+	static constexpr bool supported = true;
+	static std::vector<collapse_part_t> parts() {
+		constexpr auto half = sizeof(state_t::persons)/2;
+		return {{offsetof(state_t, boat), sizeof(boat_t)},
+				{offsetof(state_t, persons), half},
+				{offsetof(state_t, persons)+half, half}};
+	}
+};
+
+inline bool goal(const state_t& s){
+	return std::all_of(std::begin(s.persons), std::end(s.persons),
+					   [](const person_t& p) { return p.pos == person_t::shore2; });
+}
+
+/** goal over a block of states */
+inline uint64_t goal_batch(const soa_block_t<state_t>& block) {
+	auto arrived = std::array<uint8_t, soa_block_t<state_t>::lanes>{};
+	arrived.fill(1);
+	for (auto i=0u; i<8; ++i) {
+		auto& pos = block.columns[state_columns<state_t>::first_person+i];
+		for (auto l=0u; l<block.size; ++l)
+			arrived[l] &= pos[l] == person_t::shore2;
+	}
+	return lane_mask(arrived, block.size);
+}
+
+#endif //PUZZLEENGINE_FAMILY_HPP
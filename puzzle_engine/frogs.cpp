@@ -4,67 +4,24 @@
  * Author: Marius Mikucionis <marius@cs.aau.dk>
  * Compile and run:
  * g++ -std=c++17 -pedantic -Wall -DNDEBUG -O3 -o frogs frogs.cpp && ./frogs
+ * ./frogs memory 12 reports the memory of a breadth-first search with 12 frogs of each colour instead, and its
+ * hardware performance counters per phase when built with PUZZLEENGINE_PERF_COUNTERS.
+ * ./frogs trace frogs.json solves instances with up to 8 frogs of each colour on a thread pool and writes a timeline of
+ * the searches to frogs.json, which chrome://tracing or https://ui.perfetto.dev can show.
+ * ./frogs checkpoint frogs.checkpoint 14 solves 14 frogs of each colour breadth-first, saving the search to
+ * frogs.checkpoint every 100000 expansions and on SIGUSR1. If it is killed, the same command continues from the file.
+ * ./frogs persistent frogs.visited 10 keeps the visited states in frogs.visited, so running it again answers from the
+ * file without searching.
+ * ./frogs graph frogs.graph 8 writes the whole state graph to frogs.graph and reads it back with state_graph_view_t.
  */
-#include "reachability.hpp" // your header-only library solution
-
-#include <iostream>
-#include <list>
-//#include <functional> // std::function
-
-enum class frog_t { empty, green, brown };
-using stones_t = std::vector<frog_t>;
-
-std::list<std::function<void(stones_t&)>> transitions(const stones_t& stones) {
-	auto res = std::list<std::function<void(stones_t&)>>{};
-	if (stones.size()<2)
-		return res;
-	auto i=0u;
-	while (i < stones.size() && stones[i]!=frog_t::empty) ++i; // find empty stone
-	if (i==stones.size())
-		return res;  // did not find empty stone
-	// explore moves to fill the empty from left to right (only green can do that):
-	if (i > 0 && stones[i-1]==frog_t::green)
-		res.push_back([i](stones_t& s){ // green jump to next
-						  s[i-1] = frog_t::empty;
-						  s[i]   = frog_t::green;
-					  });
-	if (i > 1 && stones[i-2]==frog_t::green)
-		res.push_back([i](stones_t& s){ // green jump over 1
-						  s[i-2] = frog_t::empty;
-						  s[i]   = frog_t::green;
-					  });
-	// explore moves to fill the empty from right to left (only brown can do that):
-	if (i < stones.size()-1 && stones[i+1]==frog_t::brown) {
-		res.push_back([i](stones_t& s){ // brown jump to next
-						  s[i+1] = frog_t::empty;
-						  s[i]   = frog_t::brown;
-					  });
-	}
-	if (i < stones.size()-2 && stones[i+2]==frog_t::brown) {
-		res.push_back([i](stones_t& s){ // brown jump over 1
-						  s[i+2]=frog_t::empty;
-						  s[i]=frog_t::brown;
-					  });
-	}
-	return res;
-}
+#include "frogs.hpp" // the puzzle model
+#include "solver_pool.hpp"
+#include "state_graph.hpp"
 
-std::ostream& operator<<(std::ostream& os, const stones_t& stones) {
-	for (auto&& stone: stones)
-		switch (stone) {
-		case frog_t::green: os << "G"; break;
-		case frog_t::empty: os << "_"; break;
-		case frog_t::brown: os << "B"; break;
-		default: os << "?"; break; // something went terribly wrong
-		}
-	return os;
-}
-
-std::ostream& operator<<(std::ostream& os, const std::list<const stones_t*>& trace) {
-	for (auto stones: trace)
-		os << "State of " << stones->size() << " stones: " << *stones << '\n';
-	return os;
-}
+#include <csignal>
+#include <fstream>
+#include <tuple>
+#include <utility>
 
 void show_successors(const stones_t& state, const size_t level=0) {
 	// Caution: this function uses recursion, which is not suitable for solving puzzles!!
@@ -104,7 +61,19 @@ void explain(){
 	}
 }
 
-void solve(size_t frogs, search_order_t order = search_order_t::breadth_first){
+/** pairs of a green frog left of a brown frog, which all have to pass each other */
+double unpassed(const stones_t& stones) {
+	auto pairs = 0.0, greens = 0.0;
+	for (auto frog: stones)
+		if (frog == frog_t::green)
+			++greens;
+		else if (frog == frog_t::brown)
+			pairs += greens;
+	return pairs;
+}
+
+/** the start and the finish of the puzzle with the given number of frogs of each colour */
+std::pair<stones_t, stones_t> make_stones(size_t frogs){
 	const auto stones = frogs*2+1; // frogs on either side and 1 empty in the middle
 	auto start = stones_t(stones, frog_t::empty);  // initially all empty
 	auto finish = stones_t(stones, frog_t::empty); // initially all empty
@@ -114,9 +83,16 @@ void solve(size_t frogs, search_order_t order = search_order_t::breadth_first){
 		finish[frogs] = frog_t::brown;                 // brown on left
 		finish[finish.size()-frogs-1] = frog_t::green; // green on right
 	}
+	return {std::move(start), std::move(finish)};
+}
+
+void solve(size_t frogs, search_order_t order = search_order_t::breadth_first){
+	auto start = stones_t{}, finish = stones_t{};
+	std::tie(start, finish) = make_stones(frogs);
 	std::cout << "Leaping frog puzzle start: " << start << ", finish: " << finish << '\n';
 	// Added type specification to the template.
 	auto space = state_space_t<stones_t >(std::move(start), successors<stones_t>(transitions));
+	space.set_heuristic(&unpassed); // only used by greedy best-first search
 	auto solutions = space.check(
 		[finish=std::move(finish)](const stones_t& state){ return state==finish; },
 		order);
@@ -127,12 +103,173 @@ void solve(size_t frogs, search_order_t order = search_order_t::breadth_first){
 	}
 }
 
-int main(){
+void solve_backward(size_t frogs){
+	auto start = stones_t{}, finish = stones_t{};
+	std::tie(start, finish) = make_stones(frogs);
+	std::cout << "Leaping frog puzzle start: " << start << ", finish: " << finish << '\n';
+	auto space = state_space_t<stones_t >(std::move(start), successors<stones_t>(transitions));
+	// search from the finish towards the start, the trace is still reported from start to finish:
+	auto solutions = space.check_backward(successors<stones_t>(predecessors), {finish});
+	std::cout << "Solution: trace of " << solutions.size() << " states\n";
+	for (auto&& trace: solutions) {
+		std::cout << trace << std::endl;
+	}
+}
+
+void solve_all(size_t frogs){
+	auto start = stones_t{}, finish = stones_t{};
+	std::tie(start, finish) = make_stones(frogs);
+	std::cout << "Leaping frog puzzle start: " << start << ", finish: " << finish << '\n';
+	auto space = state_space_t<stones_t >(std::move(start), successors<stones_t>(transitions));
+	// several questions answered by one search, each trace is reported as soon as it is found:
+	auto goals = std::vector<std::function<bool(const stones_t&)>>{
+		[](const stones_t& state){ return state.front()==frog_t::empty; }, // the left stone is free
+		[](const stones_t& state){ return state.back()==frog_t::empty; },  // the right stone is free
+		[finish](const stones_t& state){ return state==finish; }};        // the frogs have swapped
+	space.check_all(goals, search_order_t::breadth_first, [](size_t goal, const std::list<stones_t>& trace){
+		std::cout << "Goal " << goal << ": trace of " << trace.size() << " states\n";
+		for (auto&& state: trace)
+			std::cout << state << '\n';
+	});
+}
+
+void solve_many(size_t maxFrogs){
+	// one job per number of frogs and search order, all solved by a pool of worker threads:
+	auto jobs = std::vector<solve_job_t<stones_t>>{};
+	for (auto frogs = size_t{1}; frogs <= maxFrogs; ++frogs) {
+		auto start = stones_t{}, finish = stones_t{};
+		std::tie(start, finish) = make_stones(frogs);
+		for (auto order: {search_order_t::breadth_first, search_order_t::depth_first})
+			jobs.push_back({start, [finish](const stones_t& state){ return state==finish; }, order});
+	}
+	auto pool = solver_pool_t<stones_t>(state_space_t<stones_t>(jobs.front().start, successors<stones_t>(transitions)));
+	auto results = pool.solve(jobs);
+	for (auto i = size_t{0}; i < results.size(); ++i) {
+		std::cout << "Frogs " << jobs[i].start << " "
+				  << (jobs[i].order == search_order_t::breadth_first ? "breadth-first" : "depth-first")
+				  << ": trace of " << results[i].trace.size() << " states, "
+				  << results[i].statistics.expanded << " states expanded\n";
+	}
+}
+
+void solve_beam(size_t frogs, size_t width){
+	auto start = stones_t{}, finish = stones_t{};
+	std::tie(start, finish) = make_stones(frogs);
+	auto space = state_space_t<stones_t>(start, successors<stones_t>(transitions));
+	// neighbouring frogs of the same colour block each other, so the states with fewer such pairs are kept:
+	auto blocked = [](const stones_t& stones){
+		auto pairs = 0.0;
+		for (auto i = size_t{1}; i < stones.size(); ++i)
+			pairs += stones[i] != frog_t::empty && stones[i] == stones[i-1];
+		return pairs;
+	};
+	auto solution = space.check_beam([finish](const stones_t& state){ return state==finish; }, width, 1024, blocked);
+	std::cout << "Frogs " << frogs << " of each colour with beam width " << width << ": trace of "
+			  << solution.size() << " states, " << space.statistics().expanded << " states expanded\n";
+}
+
+/** solves a larger puzzle breadth-first and reports the memory of the search by structure and its counters by phase */
+void measure_memory(size_t frogs){
+	auto start = stones_t{}, finish = stones_t{};
+	std::tie(start, finish) = make_stones(frogs);
+	auto space = state_space_t<stones_t>(start, successors<stones_t>(transitions));
+	space.set_memory_report(&std::cout);
+	auto solution = space.check([finish](const stones_t& state){ return state==finish; });
+	std::cout << "Frogs " << frogs << " of each colour: trace of " << solution.size() << " states, "
+			  << space.statistics().expanded << " states expanded\n";
+	std::cout << space.counters();
+}
+
+/** solves many instances in parallel and writes the timeline of the searches to path */
+void trace_many(const std::string& path){
+	start_event_trace();
+	solve_many(8);
+	stop_event_trace();
+	if (!write_event_trace(path))
+		std::cerr << "Could not write the trace to " << path << '\n';
+}
+
+/** solves breadth-first with a checkpoint at path every interval expansions and on SIGUSR1; run it again after it was
+ * killed and it continues from the last checkpoint */
+void solve_checkpointed(const std::string& path, size_t frogs, size_t interval){
+	auto start = stones_t{}, finish = stones_t{};
+	std::tie(start, finish) = make_stones(frogs);
+	if (std::ifstream(path))
+		std::cout << "Continuing from " << path << '\n';
+	std::signal(SIGUSR1, checkpoint_signal_handler);
+	auto space = state_space_t<stones_t>(start, successors<stones_t>(transitions));
+	space.enable_checkpoint(path, interval);
+	auto solution = space.check([finish](const stones_t& state){ return state==finish; });
+	std::cout << "Frogs " << frogs << " of each colour: trace of " << solution.size() << " states, "
+			  << space.statistics().expanded << " states expanded, " << space.statistics().checkpoints
+			  << " checkpoints saved\n";
+}
+
+/** answers from the visited states stored at path, and only searches for what the store does not hold yet */
+void solve_persistent(const std::string& path, size_t frogs){
+	auto start = stones_t{}, finish = stones_t{};
+	std::tie(start, finish) = make_stones(frogs);
+	auto space = state_space_t<stones_t>(start, successors<stones_t>(transitions));
+	auto solution = space.check_persistent([finish](const stones_t& state){ return state==finish; }, path, "frogs");
+	std::cout << "Frogs " << frogs << " of each colour: trace of " << solution.size() << " states, "
+			  << space.statistics().expanded << " states expanded\n";
+}
+
+/** writes the whole state graph to path and reads it back */
+void export_graph(const std::string& path, size_t frogs){
+	auto start = stones_t{}, finish = stones_t{};
+	std::tie(start, finish) = make_stones(frogs);
+	auto space = state_space_t<stones_t>(start, successors<stones_t>(transitions));
+	auto graph = state_graph_view_t{};
+	if (!space.explore_all(path) || !graph.open(path)) {
+		std::cerr << "Could not write the state graph to " << path << '\n';
+		return;
+	}
+	auto stuck = size_t{0};
+	auto state = stones_t{};
+	for (auto i = size_t{0}; i < graph.size(); ++i)
+		if (graph.successors(i).size() == 0 && graph.state(i, state) && state != finish)
+			++stuck; // no frog can move, but the frogs are not swapped
+	std::cout << "Frogs " << frogs << " of each colour: " << graph.size() << " states, " << graph.edge_count()
+			  << " moves, " << stuck << " states where the frogs are stuck\n";
+}
+
+int main(int argc, char* argv[]){
+	if (argc > 2 && std::string(argv[1]) == "memory") { // e.g. ./frogs memory 12
+		measure_memory(std::stoul(argv[2]));
+		return 0;
+	}
+	if (argc > 2 && std::string(argv[1]) == "trace") { // e.g. ./frogs trace frogs.json
+		trace_many(argv[2]);
+		return 0;
+	}
+	if (argc > 2 && std::string(argv[1]) == "checkpoint") { // e.g. ./frogs checkpoint frogs.checkpoint 14
+		solve_checkpointed(argv[2], argc > 3 ? std::stoul(argv[3]) : 14, 100000);
+		return 0;
+	}
+	if (argc > 2 && std::string(argv[1]) == "persistent") { // e.g. ./frogs persistent frogs.visited 10
+		solve_persistent(argv[2], argc > 3 ? std::stoul(argv[3]) : 10);
+		return 0;
+	}
+	if (argc > 2 && std::string(argv[1]) == "graph") { // e.g. ./frogs graph frogs.graph 8
+		export_graph(argv[2], argc > 3 ? std::stoul(argv[3]) : 8);
+		return 0;
+	}
     //explain();
 	std::cout << "--- Solve with depth-first search: ---\n";
 	solve(2, search_order_t::depth_first);
     std::cout << "--- Solve with breadth-first search: ---\n";
     solve(2); // 20 frogs may take >5.8GB of memory
+	std::cout << "--- Solve with greedy best-first search: ---\n";
+	solve(2, search_order_t::greedy_best_first);
+	std::cout << "--- Solve with backward search: ---\n";
+	solve_backward(2);
+	std::cout << "--- Solve several goals with one search: ---\n";
+	solve_all(2);
+	std::cout << "--- Solve many instances on a thread pool: ---\n";
+	solve_many(4);
+	std::cout << "--- Solve with beam search: ---\n";
+	solve_beam(20, 4);
 }
 /** Sample output:
 Leaping frog puzzle start: GG_BB
@@ -0,0 +1,106 @@
+/**
+ * Model of the frog leap puzzle: stones with green and brown frogs which leap towards the opposite side.
+ * Author: Marius Mikucionis <marius@cs.aau.dk>
+ */
+#ifndef PUZZLEENGINE_FROGS_HPP
+#define PUZZLEENGINE_FROGS_HPP
+
+#include "reachability.hpp" // your header-only library solution
+
+#include <iostream>
+#include <list>
+//#include <functional> // std::function
+
+enum class frog_t { empty, green, brown };
+using stones_t = std::vector<frog_t>;
+
+inline std::list<std::function<void(stones_t&)>> transitions(const stones_t& stones) {
+	auto res = std::list<std::function<void(stones_t&)>>{};
+	if (stones.size()<2)
+		return res;
+	auto i=0u;
+	while (i < stones.size() && stones[i]!=frog_t::empty) ++i; // find empty stone
+	if (i==stones.size())
+		return res;  // did not find empty stone
+	// explore moves to fill the empty from left to right (only green can do that):
+	if (i > 0 && stones[i-1]==frog_t::green)
+		res.push_back([i](stones_t& s){ // green jump to next
+						  s[i-1] = frog_t::empty;
+						  s[i]   = frog_t::green;
+					  });
+	if (i > 1 && stones[i-2]==frog_t::green)
+		res.push_back([i](stones_t& s){ // green jump over 1
+						  s[i-2] = frog_t::empty;
+						  s[i]   = frog_t::green;
+					  });
+	// explore moves to fill the empty from right to left (only brown can do that):
+	if (i < stones.size()-1 && stones[i+1]==frog_t::brown) {
+		res.push_back([i](stones_t& s){ // brown jump to next
+						  s[i+1] = frog_t::empty;
+						  s[i]   = frog_t::brown;
+					  });
+	}
+	if (i < stones.size()-2 && stones[i+2]==frog_t::brown) {
+		res.push_back([i](stones_t& s){ // brown jump over 1
+						  s[i+2]=frog_t::empty;
+						  s[i]=frog_t::brown;
+					  });
+	}
+	return res;
+}
+
+/**
+ * Returns a list of transitions leading into a given state, i.e. the moves of transitions() undone.
+ * Used for searching backwards from the finish.
+ */
+inline std::list<std::function<void(stones_t&)>> predecessors(const stones_t& stones) {
+	auto res = std::list<std::function<void(stones_t&)>>{};
+	if (stones.size()<2)
+		return res;
+	auto i=0u;
+	while (i < stones.size() && stones[i]!=frog_t::empty) ++i; // find empty stone
+	if (i==stones.size())
+		return res;  // did not find empty stone
+	// a green frog right of the empty stone came from it (greens only move right):
+	if (i < stones.size()-1 && stones[i+1]==frog_t::green)
+		res.push_back([i](stones_t& s){ // undo green jump to next
+						  s[i+1] = frog_t::empty;
+						  s[i]   = frog_t::green;
+					  });
+	if (i < stones.size()-2 && stones[i+2]==frog_t::green)
+		res.push_back([i](stones_t& s){ // undo green jump over 1
+						  s[i+2] = frog_t::empty;
+						  s[i]   = frog_t::green;
+					  });
+	// a brown frog left of the empty stone came from it (browns only move left):
+	if (i > 0 && stones[i-1]==frog_t::brown)
+		res.push_back([i](stones_t& s){ // undo brown jump to next
+						  s[i-1] = frog_t::empty;
+						  s[i]   = frog_t::brown;
+					  });
+	if (i > 1 && stones[i-2]==frog_t::brown)
+		res.push_back([i](stones_t& s){ // undo brown jump over 1
+						  s[i-2] = frog_t::empty;
+						  s[i]   = frog_t::brown;
+					  });
+	return res;
+}
+
+inline std::ostream& operator<<(std::ostream& os, const stones_t& stones) {
+	for (auto&& stone: stones)
+		switch (stone) {
+		case frog_t::green: os << "G"; break;
+		case frog_t::empty: os << "_"; break;
+		case frog_t::brown: os << "B"; break;
+		default: os << "?"; break; // something went terribly wrong
+		}
+	return os;
+}
+
+inline std::ostream& operator<<(std::ostream& os, const std::list<const stones_t*>& trace) {
+	for (auto stones: trace)
+		os << "State of " << stones->size() << " stones: " << *stones << '\n';
+	return os;
+}
+
+#endif //PUZZLEENGINE_FROGS_HPP
@@ -0,0 +1,105 @@
+/**
+ * A frontier stored as column arrays. Every generated state is appended as one row of the state_columns fields,
+ * together with the index of its parent row and a goal flag. The rows of a breadth first level, and the successors of
+ * a depth first expansion, are therefore contiguous in every column, which streams well through the caches instead
+ * of following a pointer to a separate node for every state.
+ */
+
+#ifndef PUZZLEENGINE_FRONTIER_HPP
+#define PUZZLEENGINE_FRONTIER_HPP
+
+#include "batch.hpp"
+#include "memory_accounting.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Tells whether state_columns of StateTypeT can also turn a row back into a state, through a static
+// unpack(row, state) function. Only such states can be kept in a column frontier.
+template<class StateTypeT, class Enable = void>
+struct has_column_unpack : std::false_type {
+};
+
+template<class StateTypeT>
+struct has_column_unpack<StateTypeT, std::void_t<decltype(state_columns<StateTypeT>::unpack(
+        std::declval<const typename state_columns<StateTypeT>::value_type *>(), std::declval<StateTypeT &>()))>>
+        : std::true_type {
+};
+
+template<class StateTypeT>
+class soa_frontier_t {
+public:
+    using layout_t = state_columns<StateTypeT>;
+    using value_type = typename layout_t::value_type;
+    static constexpr std::uint32_t npos = UINT32_MAX;
+
+    // Appends a state with the given parent row and returns its row.
+    std::uint32_t push(const StateTypeT &state, std::uint32_t parent, bool goal = false) {
+        std::array<value_type, layout_t::count> row;
+        layout_t::pack(state, row.data());
+        for (std::size_t column = 0; column < layout_t::count; ++column) {
+            _columns[column].push_back(row[column]);
+        }
+        _parents.push_back(parent);
+        _goals.push_back(goal);
+        return static_cast<std::uint32_t>(_parents.size() - 1);
+    }
+
+    // Gathers the fields of a row back into state.
+    void load(std::uint32_t index, StateTypeT &state) const {
+        std::array<value_type, layout_t::count> row;
+        for (std::size_t column = 0; column < layout_t::count; ++column) {
+            row[column] = _columns[column][index];
+        }
+        layout_t::unpack(row.data(), state);
+    }
+
+    std::uint32_t parent(std::uint32_t index) const {
+        return _parents[index];
+    }
+
+    bool goal(std::uint32_t index) const {
+        return _goals[index] != 0;
+    }
+
+    void mark_goal(std::uint32_t index) {
+        _goals[index] = 1;
+    }
+
+    // The values of one field for all rows, for loops over the whole frontier.
+    const value_type *column(std::size_t column) const {
+        return _columns[column].data();
+    }
+
+    std::size_t size() const {
+        return _parents.size();
+    }
+
+    void clear() {
+        for (auto &column: _columns) {
+            column.clear();
+        }
+        _parents.clear();
+        _goals.clear();
+    }
+
+    // Copies the rows [first, first + size) into a block, so batch predicates can run directly on the frontier.
+    void copy_to(std::uint32_t first, std::size_t size, soa_block_t<StateTypeT> &block) const {
+        for (std::size_t column = 0; column < layout_t::count; ++column) {
+            std::copy(_columns[column].begin() + first, _columns[column].begin() + first + size,
+                      block.columns[column].begin());
+        }
+        block.size = size;
+    }
+
+private:
+    std::array<accounted_vector_t<value_type, trace_memory>, layout_t::count> _columns;
+    accounted_vector_t<std::uint32_t, trace_memory> _parents;
+    accounted_vector_t<std::uint8_t, trace_memory> _goals;
+};
+
+#endif //PUZZLEENGINE_FRONTIER_HPP
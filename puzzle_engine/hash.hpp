@@ -0,0 +1,182 @@
+/**
+ * Hashing and comparison of states for the visited sets. hash_bytes is a 64 bit hash in the style of wyhash: the input is
+ * read eight bytes at a time and folded by 64x64->128 bit multiplications, which mixes every input bit into every
+ * output bit at a few cycles per word. state_hash picks the cheapest way to feed a state to it: the object bytes of
+ * states without padding, the elements of arrays and vectors of such states, std::hash where a state provides one, and
+ * otherwise the serialized form given by state_serializer. state_equal likewise compares such states with memcmp
+ * instead of their operator==, so neither needs a trait or a hash function written by the user.
+ */
+
+#ifndef PUZZLEENGINE_HASH_HPP
+#define PUZZLEENGINE_HASH_HPP
+
+#include "serialization.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace hash_detail {
+    constexpr std::uint64_t secret[4] = {0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x8ebc6af09c88c6e3ull,
+                                         0x589965cc75374cc3ull};
+
+    __extension__ typedef unsigned __int128 product_t;
+
+    // Multiplies a and b into 128 bits and folds the two halves together.
+    inline std::uint64_t mix(std::uint64_t a, std::uint64_t b) {
+        const auto product = static_cast<product_t>(a) * b;
+        return static_cast<std::uint64_t>(product) ^ static_cast<std::uint64_t>(product >> 64);
+    }
+
+    inline std::uint64_t read64(const unsigned char *bytes) {
+        std::uint64_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+
+    inline std::uint64_t read32(const unsigned char *bytes) {
+        std::uint32_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value;
+    }
+}
+
+// Hashes size bytes. Inputs of up to 16 bytes, which covers most puzzle states, take two multiplications.
+inline std::uint64_t hash_bytes(const void *bytes, std::size_t size, std::uint64_t seed = 0) {
+    using namespace hash_detail;
+    auto *data = static_cast<const unsigned char *>(bytes);
+    seed ^= mix(seed ^ secret[0], secret[1]);
+    std::uint64_t a = 0, b = 0;
+    if (size <= 16) {
+        if (size >= 4) {
+            const auto middle = (size >> 3) << 2;
+            a = (read32(data) << 32) | read32(data + middle);
+            b = (read32(data + size - 4) << 32) | read32(data + size - 4 - middle);
+        } else if (size > 0) {
+            a = (static_cast<std::uint64_t>(data[0]) << 16) | (static_cast<std::uint64_t>(data[size >> 1]) << 8) |
+                data[size - 1];
+        }
+    } else {
+        auto remaining = size;
+        if (remaining > 48) {
+            auto seed1 = seed, seed2 = seed;
+            do {
+                seed = mix(read64(data) ^ secret[1], read64(data + 8) ^ seed);
+                seed1 = mix(read64(data + 16) ^ secret[2], read64(data + 24) ^ seed1);
+                seed2 = mix(read64(data + 32) ^ secret[3], read64(data + 40) ^ seed2);
+                data += 48;
+                remaining -= 48;
+            } while (remaining > 48);
+            seed ^= seed1 ^ seed2;
+        }
+        while (remaining > 16) {
+            seed = mix(read64(data) ^ secret[1], read64(data + 8) ^ seed);
+            data += 16;
+            remaining -= 16;
+        }
+        a = read64(data + remaining - 16);
+        b = read64(data + remaining - 8);
+    }
+    const auto product = static_cast<product_t>(a ^ secret[1]) * (b ^ seed);
+    return mix(static_cast<std::uint64_t>(product) ^ secret[0] ^ size,
+               static_cast<std::uint64_t>(product >> 64) ^ secret[1]);
+}
+
+// Folds value into the hash seed, for hashing composite states field by field.
+inline std::uint64_t hash_combine(std::uint64_t seed, std::uint64_t value) {
+    return hash_detail::mix(seed ^ hash_detail::secret[0], value ^ hash_detail::secret[2]);
+}
+
+// Tells whether the object bytes of a state determine its value, so that the bytes can be hashed and compared
+// directly. This holds for integers, enumerations and structures of them without padding, but not for floating point
+// numbers. A state whose operator== deliberately ignores some of its fields should specialize state_equal and
+// state_hash to keep that meaning.
+template<class StateTypeT>
+constexpr bool is_bitwise_state_v = std::is_trivially_copyable_v<StateTypeT> &&
+                                    std::has_unique_object_representations_v<StateTypeT>;
+
+template<class StateTypeT, class Enable = void>
+struct has_std_hash : std::false_type {
+};
+
+template<class StateTypeT>
+struct has_std_hash<StateTypeT, std::void_t<decltype(std::hash<StateTypeT>{}(std::declval<const StateTypeT &>()))>>
+        : std::true_type {
+};
+
+template<class StateTypeT, class Enable = void>
+struct state_hash {
+    std::size_t operator()(const StateTypeT &state) const {
+        if constexpr (is_bitwise_state_v<StateTypeT>) {
+            return static_cast<std::size_t>(hash_bytes(&state, sizeof(state)));
+        } else if constexpr (has_std_hash<StateTypeT>::value) {
+            return static_cast<std::size_t>(hash_combine(0, std::hash<StateTypeT>{}(state)));
+        } else {
+            static_assert(state_serializer<StateTypeT>::supported,
+                          "states need std::hash, a bitwise layout or a state_serializer");
+            // The stream is kept per thread, as setting up a stream costs more than hashing a small state.
+            thread_local std::ostringstream out;
+            out.str(std::string{});
+            state_serializer<StateTypeT>::write(out, state);
+            const auto bytes = out.str();
+            return static_cast<std::size_t>(hash_bytes(bytes.data(), bytes.size()));
+        }
+    }
+};
+
+// Hashes a range of elements: as one block of bytes when the elements allow it, otherwise element by element.
+template<class ElementT>
+std::uint64_t hash_elements(const ElementT *elements, std::size_t count) {
+    if constexpr (is_bitwise_state_v<ElementT>) {
+        return hash_bytes(elements, count * sizeof(ElementT));
+    } else {
+        auto hash = hash_combine(0, count);
+        for (std::size_t i = 0; i < count; ++i) {
+            hash = hash_combine(hash, state_hash<ElementT>{}(elements[i]));
+        }
+        return hash;
+    }
+}
+
+template<class ElementT, std::size_t Size>
+struct state_hash<std::array<ElementT, Size>> {
+    std::size_t operator()(const std::array<ElementT, Size> &state) const {
+        return static_cast<std::size_t>(hash_elements(state.data(), Size));
+    }
+};
+
+template<class ElementT, class AllocatorT>
+struct state_hash<std::vector<ElementT, AllocatorT>, std::enable_if_t<!std::is_same_v<ElementT, bool>>> {
+    std::size_t operator()(const std::vector<ElementT, AllocatorT> &state) const {
+        return static_cast<std::size_t>(hash_elements(state.data(), state.size()));
+    }
+};
+
+// Compares states with memcmp when their bytes determine their value, and with operator== otherwise.
+template<class StateTypeT, class Enable = void>
+struct state_equal {
+    bool operator()(const StateTypeT &a, const StateTypeT &b) const {
+        if constexpr (is_bitwise_state_v<StateTypeT>) {
+            return std::memcmp(&a, &b, sizeof(StateTypeT)) == 0;
+        } else {
+            return a == b;
+        }
+    }
+};
+
+template<class ElementT, class AllocatorT>
+struct state_equal<std::vector<ElementT, AllocatorT>, std::enable_if_t<is_bitwise_state_v<ElementT>>> {
+    bool operator()(const std::vector<ElementT, AllocatorT> &a, const std::vector<ElementT, AllocatorT> &b) const {
+        return a.size() == b.size() &&
+               (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(ElementT)) == 0);
+    }
+};
+
+#endif //PUZZLEENGINE_HASH_HPP
@@ -0,0 +1,155 @@
+/**
+ * Collision and throughput benchmark of the state hashes over the states of the bundled puzzles.
+ * For every state type it enumerates a set of distinct states and reports, per hash function:
+ * - full: states sharing a 64 bit hash with an earlier state,
+ * - buckets: states landing in an occupied bucket of a table with at least twice as many buckets as states, next to
+ *   the number expected from a random function,
+ * - max: the largest bucket,
+ * - ns/hash: the time to hash one state.
+ * Compile and run:
+ * g++ -std=c++17 -pedantic -Wall -DNDEBUG -O3 -o hash_bench hash_bench.cpp && ./hash_bench
+ */
+#include "frogs.hpp"
+#include "crossing.hpp"
+#include "family.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// The hash used before state_hash: FNV-1a over the serialized state, one byte at a time.
+template<class StateTypeT>
+std::uint64_t fnv_hash(const StateTypeT &state) {
+    thread_local std::ostringstream out;
+    out.str(std::string{});
+    state_serializer<StateTypeT>::write(out, state);
+    const auto bytes = out.str();
+    std::uint64_t hash = 14695981039346656037ull;
+    for (auto byte: bytes) {
+        hash = (hash ^ static_cast<unsigned char>(byte)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// The family hash before hash_combine: the boat fields shifted and xor-ed, and persons hashed to zero.
+std::uint64_t shift_xor_hash(const state_t &state) {
+    auto h_pos = std::hash<decltype(state.boat.pos)>{};
+    auto h_int = std::hash<decltype(state.boat.capacity)>{};
+    auto boat = (((h_pos(state.boat.pos) << 1) ^ h_int(state.boat.capacity)) << 1) ^ h_int(state.boat.passengers);
+    return boat << 1;
+}
+
+// Receives the hashes of the timed loops, so that the compiler cannot drop them.
+volatile std::uint64_t hash_sink = 0;
+
+template<class StateTypeT, class HashT>
+void measure(const char *type, const char *name, const std::vector<StateTypeT> &states, HashT hash) {
+    const auto count = states.size();
+    std::vector<std::uint64_t> hashes;
+    hashes.reserve(count);
+    for (auto &state: states) {
+        hashes.push_back(hash(state));
+    }
+
+    auto distinct = std::unordered_set<std::uint64_t>(hashes.begin(), hashes.end()).size();
+    std::size_t buckets = 1;
+    while (buckets < 2 * count) {
+        buckets *= 2;
+    }
+    std::vector<std::uint32_t> load(buckets, 0);
+    std::size_t collisions = 0;
+    for (auto h: hashes) {
+        collisions += load[h & (buckets - 1)]++ != 0;
+    }
+    const auto maxLoad = *std::max_element(load.begin(), load.end());
+    const auto expected = static_cast<double>(count) -
+                          static_cast<double>(buckets) * (1.0 - std::pow(1.0 - 1.0 / buckets, count));
+
+    // Enough rounds for about ten million hashes, so that the timer resolution does not matter.
+    const auto rounds = std::max<std::size_t>(1, 10000000 / count);
+    std::uint64_t sink = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t round = 0; round < rounds; ++round) {
+        for (auto &state: states) {
+            sink ^= hash(state);
+        }
+    }
+    const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    hash_sink = sink;
+
+    std::printf("%-9s %-10s %8zu %8zu %8zu %10.1f %5u %9.2f\n", type, name, count, count - distinct, collisions,
+                expected, maxLoad, elapsed / static_cast<double>(rounds * count));
+}
+
+// Every arrangement of n green and n brown frogs around one empty stone, for n = 1..7.
+std::vector<stones_t> frog_states() {
+    std::vector<stones_t> states;
+    for (std::size_t frogs = 1; frogs <= 7; ++frogs) {
+        auto stones = stones_t(frogs, frog_t::green);
+        stones.push_back(frog_t::empty);
+        stones.insert(stones.end(), frogs, frog_t::brown);
+        std::sort(stones.begin(), stones.end());
+        do {
+            states.push_back(stones);
+        } while (std::next_permutation(stones.begin(), stones.end()));
+    }
+    return states;
+}
+
+// Every position of the cabbage, the goat and the wolf.
+std::vector<actors_t> crossing_states() {
+    std::vector<actors_t> states;
+    for (auto code = 0u; code < 27; ++code) {
+        auto actors = actors_t{};
+        for (auto i = 0u, rest = code; i < actors.size(); ++i, rest /= 3) {
+            actors[i] = static_cast<pos_t>(rest % 3);
+        }
+        states.push_back(actors);
+    }
+    return states;
+}
+
+// Every boat position and passenger count combined with every position of the eight persons.
+std::vector<state_t> family_states() {
+    std::vector<state_t> states;
+    for (auto boat = 0u; boat < 3; ++boat) {
+        for (auto passengers = 0u; passengers <= 2; ++passengers) {
+            for (auto code = 0u; code < 6561; ++code) {
+                auto state = state_t{};
+                state.boat.pos = decltype(state.boat.pos)(boat);
+                state.boat.passengers = static_cast<uint16_t>(passengers);
+                for (auto i = 0u, rest = code; i < state.persons.size(); ++i, rest /= 3) {
+                    state.persons[i].pos = decltype(state.persons[i].pos)(rest % 3);
+                }
+                states.push_back(state);
+            }
+        }
+    }
+    return states;
+}
+
+int main() {
+    std::printf("%-9s %-10s %8s %8s %8s %10s %5s %9s\n", "type", "hash", "states", "full", "buckets", "expected",
+                "max", "ns/hash");
+
+    const auto frogs = frog_states();
+    measure("stones_t", "state_hash", frogs, state_hash<stones_t>{});
+    measure("stones_t", "fnv-1a", frogs, &fnv_hash<stones_t>);
+
+    const auto crossing = crossing_states();
+    measure("actors_t", "state_hash", crossing, state_hash<actors_t>{});
+    measure("actors_t", "fnv-1a", crossing, &fnv_hash<actors_t>);
+
+    const auto family = family_states();
+    measure("state_t", "state_hash", family, state_hash<state_t>{});
+    measure("state_t", "std::hash", family, std::hash<state_t>{});
+    measure("state_t", "fnv-1a", family, &fnv_hash<state_t>);
+    measure("state_t", "shift-xor", family, &shift_xor_hash);
+}
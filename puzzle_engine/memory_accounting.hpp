@@ -0,0 +1,233 @@
+/**
+ * Accounting of the memory held by searches. The containers of the engine allocate through accounting_allocator_t,
+ * which adds every allocation to the current bytes of a memory_tag_t and keeps the peak of each tag. The memory that
+ * states own themselves, like the elements of a vector state, is allocated by the state type and not by the engine, so
+ * the trace store and the visited sets measure it with state_heap_bytes as they store states and account it under
+ * state_memory. memory_report() collects the figures of all tags together with the resident set size of the process
+ * from /proc/self/status, which also covers what the accounting cannot see: the heap overhead of each allocation,
+ * other copies of states, and the rest of the program.
+ */
+
+#ifndef PUZZLEENGINE_MEMORY_ACCOUNTING_HPP
+#define PUZZLEENGINE_MEMORY_ACCOUNTING_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+enum memory_tag_t {
+    trace_memory,   // the trace_nodes and other stores of generated states with their parents
+    passed_memory,  // the passed and visited sets
+    waiting_memory, // the waiting lists and open lists, and the buffers of expansions
+    graph_memory,   // cached state graphs
+    state_memory,   // the memory owned by the stored states themselves, see state_heap_bytes
+    memory_tag_count
+};
+
+inline const char *memory_tag_name(memory_tag_t tag) {
+    static constexpr const char *names[memory_tag_count] = {"trace", "passed", "waiting", "graph", "states"};
+    return names[tag];
+}
+
+// The current and peak bytes of one tag, shared by all threads.
+struct memory_account_t {
+    std::atomic<std::int64_t> current{0};
+    std::atomic<std::int64_t> peak{0};
+};
+
+inline std::array<memory_account_t, memory_tag_count> &memory_accounts() {
+    static std::array<memory_account_t, memory_tag_count> accounts;
+    return accounts;
+}
+
+// Adds bytes, which are negative when memory is released, to the current bytes of tag and raises its peak.
+inline void account_memory(memory_tag_t tag, std::int64_t bytes) {
+    auto &account = memory_accounts()[tag];
+    const auto current = account.current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    auto peak = account.peak.load(std::memory_order_relaxed);
+    while (current > peak && !account.peak.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+    }
+}
+
+// Lowers the peak of every tag to its current bytes, so that the next report shows the peaks of what runs after.
+inline void reset_memory_peaks() {
+    for (auto &account: memory_accounts()) {
+        account.peak.store(account.current.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+// A std::allocator that accounts its allocations under Tag.
+template<class T, memory_tag_t Tag>
+struct accounting_allocator_t {
+    using value_type = T;
+
+    template<class U>
+    struct rebind {
+        using other = accounting_allocator_t<U, Tag>;
+    };
+
+    accounting_allocator_t() = default;
+
+    template<class U>
+    accounting_allocator_t(const accounting_allocator_t<U, Tag> &) {
+    }
+
+    T *allocate(std::size_t count) {
+        auto *memory = std::allocator<T>{}.allocate(count);
+        account_memory(Tag, static_cast<std::int64_t>(count * sizeof(T)));
+        return memory;
+    }
+
+    void deallocate(T *memory, std::size_t count) {
+        account_memory(Tag, -static_cast<std::int64_t>(count * sizeof(T)));
+        std::allocator<T>{}.deallocate(memory, count);
+    }
+
+    template<class U>
+    bool operator==(const accounting_allocator_t<U, Tag> &) const {
+        return true;
+    }
+
+    template<class U>
+    bool operator!=(const accounting_allocator_t<U, Tag> &) const {
+        return false;
+    }
+};
+
+template<class T, memory_tag_t Tag>
+using accounted_vector_t = std::vector<T, accounting_allocator_t<T, Tag>>;
+
+// The heap bytes a state owns beyond its own size. Zero unless specialized, which suits states that are plain values.
+// Vectors count their capacity and what their elements own in turn.
+template<class StateTypeT, class Enable = void>
+struct state_heap_bytes {
+    static std::size_t of(const StateTypeT &) {
+        return 0;
+    }
+};
+
+template<class T, class AllocatorT>
+struct state_heap_bytes<std::vector<T, AllocatorT>> {
+    static std::size_t of(const std::vector<T, AllocatorT> &state) {
+        auto bytes = state.capacity() * sizeof(T);
+        if constexpr (!std::is_trivially_copyable<T>::value) {
+            for (auto &element: state) {
+                bytes += state_heap_bytes<T>::of(element);
+            }
+        }
+        return bytes;
+    }
+};
+
+// The state bytes held by a container. A copy of the container copies its states and so holds the same bytes again,
+// a moved container hands them over, and they are released when the container is destroyed.
+template<memory_tag_t Tag>
+class accounted_bytes_t {
+public:
+    accounted_bytes_t() = default;
+
+    accounted_bytes_t(const accounted_bytes_t &other) {
+        add(other._bytes);
+    }
+
+    accounted_bytes_t(accounted_bytes_t &&other) noexcept : _bytes(other._bytes) {
+        other._bytes = 0;
+    }
+
+    accounted_bytes_t &operator=(const accounted_bytes_t &other) {
+        add(other._bytes - _bytes);
+        return *this;
+    }
+
+    accounted_bytes_t &operator=(accounted_bytes_t &&other) noexcept {
+        add(-_bytes);
+        _bytes = other._bytes;
+        other._bytes = 0;
+        return *this;
+    }
+
+    ~accounted_bytes_t() {
+        add(-_bytes);
+    }
+
+    void add(std::int64_t bytes) {
+        if (bytes != 0) {
+            _bytes += bytes;
+            account_memory(Tag, bytes);
+        }
+    }
+
+    void reset() {
+        add(-_bytes);
+    }
+
+private:
+    std::int64_t _bytes{0};
+};
+
+// The figures of all tags, and the resident and peak resident bytes of the process, or -1 where /proc/self/status
+// could not be read.
+struct memory_report_t {
+    struct usage_t {
+        std::int64_t current;
+        std::int64_t peak;
+    };
+
+    std::array<usage_t, memory_tag_count> tags{};
+    std::int64_t resident{-1};
+    std::int64_t peakResident{-1};
+
+    std::int64_t current() const {
+        std::int64_t bytes = 0;
+        for (auto &tag: tags) {
+            bytes += tag.current;
+        }
+        return bytes;
+    }
+};
+
+inline memory_report_t memory_report() {
+    memory_report_t report;
+    for (std::size_t tag = 0; tag < memory_tag_count; ++tag) {
+        report.tags[tag] = {memory_accounts()[tag].current.load(std::memory_order_relaxed),
+                            memory_accounts()[tag].peak.load(std::memory_order_relaxed)};
+    }
+    std::ifstream status("/proc/self/status");
+    std::string key;
+    std::int64_t kilobytes;
+    while (status >> key) {
+        if (key == "VmRSS:" && status >> kilobytes) {
+            report.resident = kilobytes * 1024;
+        } else if (key == "VmHWM:" && status >> kilobytes) {
+            report.peakResident = kilobytes * 1024;
+        }
+    }
+    return report;
+}
+
+// Prints the report in KiB, one line per tag and a line with the totals and the resident set size.
+inline std::ostream &operator<<(std::ostream &os, const memory_report_t &report) {
+    auto kib = [](std::int64_t bytes) {
+        return bytes < 0 ? bytes : (bytes + 1023) / 1024;
+    };
+    os << std::left << std::setw(9) << "memory" << std::right << std::setw(14) << "current KiB" << std::setw(14)
+       << "peak KiB" << '\n';
+    for (std::size_t tag = 0; tag < memory_tag_count; ++tag) {
+        os << std::left << std::setw(9) << memory_tag_name(static_cast<memory_tag_t>(tag)) << std::right
+           << std::setw(14) << kib(report.tags[tag].current) << std::setw(14) << kib(report.tags[tag].peak) << '\n';
+    }
+    os << std::left << std::setw(9) << "total" << std::right << std::setw(14) << kib(report.current()) << '\n';
+    os << std::left << std::setw(9) << "resident" << std::right << std::setw(14) << kib(report.resident)
+       << std::setw(14) << kib(report.peakResident) << '\n';
+    return os;
+}
+
+#endif //PUZZLEENGINE_MEMORY_ACCOUNTING_HPP
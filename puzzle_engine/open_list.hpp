@@ -0,0 +1,440 @@
+/**
+ * Open lists for cost ordered searches. An open list holds pairs of cost and value and pops the pair with the lowest
+ * cost first. They replace sorting the whole waiting list after every expansion. The open_list_for_t alias picks the
+ * implementation from the cost type.
+ */
+
+#ifndef PUZZLEENGINE_OPEN_LIST_HPP
+#define PUZZLEENGINE_OPEN_LIST_HPP
+
+#include "event_trace.hpp"
+#include "memory_accounting.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Maps a cost onto a non-negative integer key that preserves the order of costs. When the costs never decrease along
+// a path (like depths and step counts), such keys allow the radix heap below. Integral costs are supported out of the
+// box, other cost types can specialize the trait with supported set to true and a static key function. Signed costs
+// get their sign bit flipped, so that negative costs come before the positive ones.
+template<class CostTypeT, class Enable = void>
+struct monotone_cost_key {
+    static constexpr bool supported = false;
+};
+
+template<class CostTypeT>
+struct monotone_cost_key<CostTypeT, std::enable_if_t<std::is_integral<CostTypeT>::value>> {
+    static constexpr bool supported = true;
+
+    static std::uint64_t key(const CostTypeT &cost) {
+        if constexpr (std::is_signed<CostTypeT>::value) {
+            return static_cast<std::uint64_t>(static_cast<std::int64_t>(cost)) ^ (1ull << 63);
+        } else {
+            return static_cast<std::uint64_t>(cost);
+        }
+    }
+};
+
+// Splits a cost into a tuple of small non-negative integers whose lexicographic order is the order of the costs, like
+// a pair of depth and noise compared depth first. Such costs can use the bucket open list below. Cost types opt in by
+// specializing the trait with supported set to true, the number of levels and a static decompose function.
+template<class CostTypeT, class Enable = void>
+struct cost_decomposition {
+    static constexpr bool supported = false;
+};
+
+// The general open list, a binary heap that only needs operator< on the costs. Each pair gets a sequence number,
+// which breaks ties between equal costs in push order, exactly like the stable sort of the waiting list did.
+template<class CostTypeT, class ValueT>
+class heap_open_list_t {
+public:
+    void push(const CostTypeT &cost, const ValueT &value) {
+        _heap.push_back(entry_t{std::make_pair(cost, value), _sequence++});
+        std::push_heap(_heap.begin(), _heap.end(), later);
+    }
+
+    std::pair<CostTypeT, ValueT> pop() {
+        std::pop_heap(_heap.begin(), _heap.end(), later);
+        auto element = std::move(_heap.back().element);
+        _heap.pop_back();
+        return element;
+    }
+
+    bool empty() const {
+        return _heap.empty();
+    }
+
+    std::size_t size() const {
+        return _heap.size();
+    }
+
+    void clear() {
+        _heap.clear();
+        _sequence = 0;
+    }
+
+    // Calls fn with every pair in push order, so that pushing them again in that order restores the open list.
+    template<class FunctionT>
+    void for_each(FunctionT fn) const {
+        std::vector<const entry_t *> entries;
+        entries.reserve(_heap.size());
+        for (auto &entry: _heap) {
+            entries.push_back(&entry);
+        }
+        std::sort(entries.begin(), entries.end(),
+                  [](const entry_t *a, const entry_t *b) { return a->sequence < b->sequence; });
+        for (auto *entry: entries) {
+            fn(entry->element);
+        }
+    }
+
+private:
+    struct entry_t {
+        std::pair<CostTypeT, ValueT> element;
+        std::uint64_t sequence;
+    };
+
+    accounted_vector_t<entry_t, waiting_memory> _heap;
+    std::uint64_t _sequence{0};
+
+    // The heap functions keep the greatest element on top, so the comparison tells which entry should be popped later.
+    static bool later(const entry_t &a, const entry_t &b) {
+        if (a.element.first < b.element.first) {
+            return false;
+        }
+        if (b.element.first < a.element.first) {
+            return true;
+        }
+        return b.sequence < a.sequence;
+    }
+};
+
+// A radix heap over the keys of monotone_cost_key. Bucket i holds the pairs whose key differs from the last popped
+// key in bit i-1 as the highest bit, so bucket 0 holds the pairs with exactly the last popped key. A pop only
+// scans the buckets when bucket 0 is empty, and then moves the pairs of the first non-empty bucket into lower
+// buckets, which each pair can only do 64 times. No costs are compared at all.
+template<class CostTypeT, class ValueT>
+class radix_heap_open_list_t {
+public:
+    void push(const CostTypeT &cost, const ValueT &value) {
+        const auto key = monotone_cost_key<CostTypeT>::key(cost);
+        if (key < _last) {
+            // The costs decreased along a path, which the keys do not allow for. Starting the buckets over from the
+            // new key keeps the list correct at the price of moving every pair.
+            rebucket(key);
+        }
+        _buckets[bucketOf(key)].push_back(entry_t{key, std::make_pair(cost, value)});
+        ++_size;
+    }
+
+    std::pair<CostTypeT, ValueT> pop() {
+        if (_front == _buckets[0].size()) {
+            _buckets[0].clear();
+            _front = 0;
+            auto bucket = 1u;
+            while (_buckets[bucket].empty()) {
+                ++bucket;
+            }
+            auto lowest = _buckets[bucket].front().key;
+            for (auto &entry: _buckets[bucket]) {
+                lowest = std::min(lowest, entry.key);
+            }
+            // The pairs of higher buckets agree with the new reference key on all bits their bucket depends on, so
+            // only this bucket has to be distributed.
+            rebucket(lowest, bucket);
+        }
+        --_size;
+        return std::move(_buckets[0][_front++].element);
+    }
+
+    bool empty() const {
+        return _size == 0;
+    }
+
+    std::size_t size() const {
+        return _size;
+    }
+
+    void clear() {
+        for (auto &bucket: _buckets) {
+            bucket.clear();
+        }
+        _front = 0;
+        _size = 0;
+        _last = 0;
+    }
+
+    template<class FunctionT>
+    void for_each(FunctionT fn) const {
+        for (auto i = _front; i < _buckets[0].size(); ++i) {
+            fn(_buckets[0][i].element);
+        }
+        for (auto bucket = 1u; bucket < _buckets.size(); ++bucket) {
+            for (auto &entry: _buckets[bucket]) {
+                fn(entry.element);
+            }
+        }
+    }
+
+private:
+    struct entry_t {
+        std::uint64_t key;
+        std::pair<CostTypeT, ValueT> element;
+    };
+
+    std::array<accounted_vector_t<entry_t, waiting_memory>, 65> _buckets;
+    accounted_vector_t<entry_t, waiting_memory> _moving; // reused while moving pairs between buckets
+    std::size_t _front{0}; // the pairs of bucket 0 before this index have been popped
+    std::size_t _size{0};
+    std::uint64_t _last{0};
+
+    std::size_t bucketOf(std::uint64_t key) const {
+        auto difference = key ^ _last;
+        return difference == 0 ? 0 : 64 - static_cast<std::size_t>(__builtin_clzll(difference));
+    }
+
+    // Makes last the reference key and moves the pairs of the given buckets into the buckets they belong to relative
+    // to it. The pairs are visited in bucket order, which keeps pairs of equal keys in push order as far as possible.
+    void rebucket(std::uint64_t last, std::size_t lastBucket = 64) {
+        trace_span_t span("waiting", "rebucket", "moved");
+        auto &entries = _moving;
+        entries.clear();
+        for (auto i = _front; i < _buckets[0].size(); ++i) {
+            entries.push_back(std::move(_buckets[0][i]));
+        }
+        _buckets[0].clear();
+        _front = 0;
+        for (auto bucket = 1u; bucket <= lastBucket; ++bucket) {
+            for (auto &entry: _buckets[bucket]) {
+                entries.push_back(std::move(entry));
+            }
+            _buckets[bucket].clear();
+        }
+        _last = last;
+        span.set_value(entries.size());
+        for (auto &entry: entries) {
+            _buckets[bucketOf(entry.key)].push_back(std::move(entry));
+        }
+    }
+};
+
+// A nested bucket queue over the tuples of cost_decomposition. Every level of the tuple is a node with a vector of
+// children indexed by that component, less the lowest component the node has seen, and the pairs of equal tuples share
+// a bucket at the bottom, where they are kept in push order. Each node remembers the lowest child that may be
+// non-empty, so a pop walks down the cursors without comparing any costs. Cursors only move back when a lower cost is
+// pushed, which a search with non-decreasing costs never does. A node spans at most max_span components, and a push
+// beyond that, e.g. of a large noise or of a negative component, moves all pairs into a heap_open_list_t, which serves
+// the list until it is cleared. Clearing keeps the nodes and buckets with their memory for the next search.
+template<class CostTypeT, class ValueT>
+class bucket_open_list_t {
+public:
+    static constexpr std::size_t levels = cost_decomposition<CostTypeT>::levels;
+    static constexpr std::size_t max_span = std::size_t{1} << 16;
+
+    bucket_open_list_t() {
+        clear();
+    }
+
+    void push(const CostTypeT &cost, const ValueT &value) {
+        if (_spilled) {
+            _heap.push(cost, value);
+            return;
+        }
+        const auto components = cost_decomposition<CostTypeT>::decompose(cost);
+        std::array<std::uint32_t, levels> path{};
+        auto index = std::uint32_t{0};
+        for (std::size_t level = 0; level < levels; ++level) {
+            path[level] = index;
+            const auto child = childOf(_nodes[level][index], static_cast<std::size_t>(components[level]));
+            if (child == SIZE_MAX) {
+                spill();
+                _heap.push(cost, value);
+                return;
+            }
+            if (_nodes[level][index].children[child] == npos) {
+                const auto allocated = allocate(level + 1);
+                _nodes[level][index].children[child] = allocated;
+            }
+            auto &node = _nodes[level][index];
+            node.cursor = std::min(node.cursor, child);
+            index = node.children[child];
+        }
+        _buckets[index].entries.push_back(std::make_pair(cost, value));
+        for (std::size_t level = 0; level < levels; ++level) {
+            ++_nodes[level][path[level]].count;
+        }
+        ++_size;
+    }
+
+    std::pair<CostTypeT, ValueT> pop() {
+        if (_spilled) {
+            return _heap.pop();
+        }
+        auto index = std::uint32_t{0};
+        for (std::size_t level = 0; level < levels; ++level) {
+            auto &node = _nodes[level][index];
+            while (node.children[node.cursor] == npos || count(level + 1, node.children[node.cursor]) == 0) {
+                ++node.cursor;
+            }
+            --node.count;
+            index = node.children[node.cursor];
+        }
+        auto &bucket = _buckets[index];
+        auto element = std::move(bucket.entries[bucket.front++]);
+        if (bucket.front == bucket.entries.size()) {
+            bucket.entries.clear();
+            bucket.front = 0;
+        }
+        --_size;
+        return element;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    std::size_t size() const {
+        return _spilled ? _heap.size() : _size;
+    }
+
+    void clear() {
+        _used.fill(0);
+        _usedBuckets = 0;
+        allocate(0);
+        _size = 0;
+        _heap.clear();
+        _spilled = false;
+    }
+
+    // Calls fn with every pair in cost order, and in push order within equal costs. Once the pairs are in the heap,
+    // fn is called in push order instead.
+    template<class FunctionT>
+    void for_each(FunctionT fn) const {
+        if (_spilled) {
+            _heap.for_each(fn);
+        } else {
+            visit(0, 0, fn);
+        }
+    }
+
+private:
+    static constexpr std::uint32_t npos = UINT32_MAX;
+
+    struct node_t {
+        // node of the next level, or bucket below the last level, by component less base:
+        accounted_vector_t<std::uint32_t, waiting_memory> children;
+        std::size_t base{0};                 // the component of the first child
+        std::size_t cursor{SIZE_MAX};        // no child before this one holds any pairs
+        std::size_t count{0};                // pairs below this node
+    };
+
+    struct bucket_t {
+        accounted_vector_t<std::pair<CostTypeT, ValueT>, waiting_memory> entries;
+        std::size_t front{0}; // entries before this index have been popped
+    };
+
+    // The nodes and buckets before the used counts are in the list, the ones after them are kept from earlier use.
+    std::array<accounted_vector_t<node_t, waiting_memory>, levels> _nodes;
+    accounted_vector_t<bucket_t, waiting_memory> _buckets;
+    std::array<std::size_t, levels> _used{};
+    std::size_t _usedBuckets{0};
+    std::size_t _size{0};
+    heap_open_list_t<CostTypeT, ValueT> _heap; // holds all pairs once a push went beyond max_span
+    bool _spilled{false};
+
+    // Returns the position of the child for component in node, making room for it, or SIZE_MAX if the node would
+    // span more than max_span components.
+    static std::size_t childOf(node_t &node, std::size_t component) {
+        if (node.children.empty()) {
+            node.base = component;
+        }
+        if (component < node.base) {
+            const auto shift = node.base - component;
+            if (shift >= max_span || node.children.size() + shift > max_span) {
+                return SIZE_MAX;
+            }
+            node.children.insert(node.children.begin(), shift, npos);
+            node.base = component;
+            if (node.cursor != SIZE_MAX) {
+                node.cursor += shift;
+            }
+        } else if (component - node.base >= node.children.size()) {
+            if (component - node.base >= max_span) {
+                return SIZE_MAX;
+            }
+            node.children.resize(component - node.base + 1, npos);
+        }
+        return component - node.base;
+    }
+
+    // Moves all pairs into the heap in cost order, so pairs of equal costs keep their push order.
+    void spill() {
+        trace_span_t span("waiting", "spill", "moved", _size);
+        auto push = [this](const std::pair<CostTypeT, ValueT> &element) {
+            _heap.push(element.first, element.second);
+        };
+        visit(0, 0, push);
+        _spilled = true;
+    }
+
+    std::uint32_t allocate(std::size_t level) {
+        if (level == levels) {
+            if (_usedBuckets == _buckets.size()) {
+                _buckets.emplace_back();
+            } else {
+                _buckets[_usedBuckets].entries.clear();
+                _buckets[_usedBuckets].front = 0;
+            }
+            return static_cast<std::uint32_t>(_usedBuckets++);
+        }
+        if (_used[level] == _nodes[level].size()) {
+            _nodes[level].emplace_back();
+        } else {
+            auto &node = _nodes[level][_used[level]];
+            node.children.clear();
+            node.base = 0;
+            node.cursor = SIZE_MAX;
+            node.count = 0;
+        }
+        return static_cast<std::uint32_t>(_used[level]++);
+    }
+
+    std::size_t count(std::size_t level, std::uint32_t index) const {
+        if (level == levels) {
+            return _buckets[index].entries.size() - _buckets[index].front;
+        }
+        return _nodes[level][index].count;
+    }
+
+    template<class FunctionT>
+    void visit(std::size_t level, std::uint32_t index, FunctionT &fn) const {
+        if (level == levels) {
+            auto &bucket = _buckets[index];
+            for (auto i = bucket.front; i < bucket.entries.size(); ++i) {
+                fn(bucket.entries[i]);
+            }
+            return;
+        }
+        for (auto child: _nodes[level][index].children) {
+            if (child != npos) {
+                visit(level + 1, child, fn);
+            }
+        }
+    }
+};
+
+// Selects the open list for a cost type: the bucket queue when the costs decompose into lexicographic tuples, the radix
+// heap when the costs map onto monotone integer keys, and the binary heap otherwise.
+template<class CostTypeT, class ValueT>
+using open_list_for_t = std::conditional_t<cost_decomposition<CostTypeT>::supported,
+        bucket_open_list_t<CostTypeT, ValueT>,
+        std::conditional_t<monotone_cost_key<CostTypeT>::supported,
+                radix_heap_open_list_t<CostTypeT, ValueT>,
+                heap_open_list_t<CostTypeT, ValueT>>>;
+
+#endif //PUZZLEENGINE_OPEN_LIST_HPP
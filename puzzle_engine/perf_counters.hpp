@@ -0,0 +1,193 @@
+/**
+ * Hardware performance counters per search phase. With PUZZLEENGINE_PERF_COUNTERS defined, each thread opens a group
+ * of Linux perf events counting cycles, instructions, last level cache misses and branch misses in user space, and
+ * the searches wrap their phases in perf_phase_t scopes: generating successors, checking the invariant, looking up
+ * the visited states and operating on waiting. A phase that starts inside another, like the visited lookup of a
+ * successor while successors are generated, pauses the outer one, so every event is counted for exactly one phase,
+ * and whatever the search does outside these phases is counted as other. Reading the counters takes a system call
+ * at every change of phase, which slows the search down considerably but is not counted, as the kernel is excluded.
+ * Without the macro, which is the default, the scopes are empty and no counters are opened.
+ */
+
+#ifndef PUZZLEENGINE_PERF_COUNTERS_HPP
+#define PUZZLEENGINE_PERF_COUNTERS_HPP
+
+#include <array>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+
+#ifdef PUZZLEENGINE_PERF_COUNTERS
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+enum search_phase_t {
+    other_phase, successor_phase, invariant_phase, visited_phase, frontier_phase, search_phase_count
+};
+
+inline const char *search_phase_name(search_phase_t phase) {
+    static constexpr const char *names[search_phase_count] = {"other", "successors", "invariant", "visited",
+                                                              "frontier"};
+    return names[phase];
+}
+
+enum perf_event_t {
+    cycles_event, instructions_event, cache_misses_event, branch_misses_event, perf_event_count
+};
+
+// The events counted in each phase of a search. available is false when the counters are compiled out or could not
+// be opened, e.g. because perf_event_paranoid forbids it or the machine has no hardware counters.
+struct search_counters_t {
+    bool available{false};
+    std::array<std::array<std::uint64_t, perf_event_count>, search_phase_count> phases{};
+};
+
+inline std::ostream &operator<<(std::ostream &os, const search_counters_t &counters) {
+    if (!counters.available) {
+#ifdef PUZZLEENGINE_PERF_COUNTERS
+        return os << "perf counters could not be opened\n";
+#else
+        return os << "perf counters are disabled, see PUZZLEENGINE_PERF_COUNTERS\n";
+#endif
+    }
+    os << std::left << std::setw(11) << "phase" << std::right << std::setw(14) << "cycles" << std::setw(14)
+       << "instructions" << std::setw(7) << "IPC" << std::setw(12) << "LLC misses" << std::setw(14) << "branch misses"
+       << '\n';
+    for (std::size_t phase = 0; phase < search_phase_count; ++phase) {
+        auto &events = counters.phases[phase];
+        const auto ipc = events[cycles_event] == 0 ? 0.0 : static_cast<double>(events[instructions_event]) /
+                                                           static_cast<double>(events[cycles_event]);
+        os << std::left << std::setw(11) << search_phase_name(static_cast<search_phase_t>(phase)) << std::right
+           << std::setw(14) << events[cycles_event] << std::setw(14) << events[instructions_event] << std::setw(7)
+           << std::fixed << std::setprecision(2) << ipc << std::setw(12) << events[cache_misses_event]
+           << std::setw(14) << events[branch_misses_event] << '\n';
+    }
+    return os;
+}
+
+#ifdef PUZZLEENGINE_PERF_COUNTERS
+
+// The counter group of the calling thread and the counts of the search running on it.
+class perf_recorder_t {
+public:
+    static perf_recorder_t &thread() {
+        thread_local perf_recorder_t recorder;
+        return recorder;
+    }
+
+    // Starts counting a search in other_phase.
+    void begin() {
+        _counters = search_counters_t{};
+        _counters.available = _leader >= 0;
+        _phase = other_phase;
+        read(_last);
+    }
+
+    // Counts the events since the last change of phase for the current phase and switches to phase. Returns the
+    // phase that was current.
+    search_phase_t enter(search_phase_t phase) {
+        std::array<std::uint64_t, perf_event_count> now{};
+        read(now);
+        for (std::size_t event = 0; event < perf_event_count; ++event) {
+            _counters.phases[_phase][event] += now[event] - _last[event];
+        }
+        _last = now;
+        const auto previous = _phase;
+        _phase = phase;
+        return previous;
+    }
+
+    const search_counters_t &end() {
+        enter(other_phase);
+        return _counters;
+    }
+
+    perf_recorder_t(const perf_recorder_t &) = delete;
+
+    perf_recorder_t &operator=(const perf_recorder_t &) = delete;
+
+    ~perf_recorder_t() {
+        for (auto fd: _fds) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    }
+
+private:
+    std::array<int, perf_event_count> _fds{-1, -1, -1, -1};
+    int _leader{-1};
+    search_counters_t _counters;
+    search_phase_t _phase{other_phase};
+    std::array<std::uint64_t, perf_event_count> _last{};
+
+    perf_recorder_t() {
+        static constexpr std::uint64_t configs[perf_event_count] = {
+                PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+                PERF_COUNT_HW_BRANCH_MISSES};
+        for (std::size_t event = 0; event < perf_event_count; ++event) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = configs[event];
+            attr.disabled = event == 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+            _fds[event] = static_cast<int>(::syscall(__NR_perf_event_open, &attr, 0, -1, event == 0 ? -1 : _fds[0],
+                                                     0));
+            if (_fds[event] < 0) {
+                return;
+            }
+        }
+        _leader = _fds[0];
+        ::ioctl(_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ::ioctl(_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+
+    void read(std::array<std::uint64_t, perf_event_count> &values) const {
+        struct {
+            std::uint64_t count;
+            std::uint64_t values[perf_event_count];
+        } group{};
+        if (_leader >= 0 && ::read(_leader, &group, sizeof(group)) == static_cast<ssize_t>(sizeof(group))) {
+            std::memcpy(values.data(), group.values, sizeof(group.values));
+        }
+    }
+};
+
+// Counts the events of its lifetime for phase, and then returns to the phase that was current before.
+class perf_phase_t {
+public:
+    explicit perf_phase_t(search_phase_t phase) : _previous(perf_recorder_t::thread().enter(phase)) {
+    }
+
+    perf_phase_t(const perf_phase_t &) = delete;
+
+    perf_phase_t &operator=(const perf_phase_t &) = delete;
+
+    ~perf_phase_t() {
+        perf_recorder_t::thread().enter(_previous);
+    }
+
+private:
+    search_phase_t _previous;
+};
+
+#else
+
+class perf_phase_t {
+public:
+    explicit perf_phase_t(search_phase_t) {
+    }
+};
+
+#endif
+
+#endif //PUZZLEENGINE_PERF_COUNTERS_HPP
@@ -12,25 +12,53 @@
 #ifndef PUZZLEENGINE_REACHABILITY_HPP
 #define PUZZLEENGINE_REACHABILITY_HPP
 
+#include "search_state.hpp"
+#include "checkpoint.hpp"
+#include "visited_store.hpp"
+#include "open_list.hpp"
+#include "batch.hpp"
+#include "frontier.hpp"
+#include "visited_set.hpp"
+#include "state_graph.hpp"
+#include "scratch_pool.hpp"
+#include "compiled_space.hpp"
+#include "perf_counters.hpp"
+#include "event_trace.hpp"
+
+#include <array>
 #include <vector>
+#include <limits>
 #include <list>
 #include <functional>
 #include <iostream>
 #include <algorithm>
+#include <memory>
+#include <mutex>
+#include <numeric>
 #include <typeinfo>
+#include <unordered_map>
+#include <type_traits>
 
 // This enum is used to handle the support for different search orders except for cost order. It is implemented
-// as part of requirement 5.
+// as part of requirement 5. greedy_best_first always takes the waiting state with the lowest heuristic value first,
+// see set_heuristic.
 enum search_order_t {
-    breadth_first, depth_first
+    breadth_first, depth_first, greedy_best_first
 };
 
-// This struct is the basis for keeping track of the solution when traversing the states. When it is used, it holds a
-// pointer to the parent node as well as a copy of the state.
-template<class StateTypeT>
-struct trace_node {
-    trace_node *parentState;
-    StateTypeT selfState;
+// This enum selects when breadth and depth first searches detect duplicate states. When generated, a successor that
+// was reached before is not added to waiting at all, so every state is in waiting at most once. When expanded, every
+// valid successor is added and the duplicates are skipped as they are taken from waiting, which depth first searches
+// need to follow the most recently reached copy of a state. The default detects them when generated in breadth first
+// searches and when expanded in depth first searches.
+enum duplicate_detection_t {
+    default_detection, detect_when_generated, detect_when_expanded
+};
+
+// This enum selects how the ordered searches keep their waiting states: as a list of pointers to trace_nodes, or as
+// the column arrays of soa_frontier_t, which requires state_columns with unpack for the state type.
+enum frontier_layout_t {
+    node_list, column_arrays
 };
 
 // This function is used to pass on the transition generator function from the respective puzzles. It is implemented
@@ -41,8 +69,22 @@ successors(std::list<std::function<void(StateTypeT &)>> transitions(const StateT
     return transitions;
 }
 
+// A mutex member that does not stand in the way of copying its owner: a copy gets a new mutex of its own.
+struct copyable_mutex_t : std::mutex {
+    copyable_mutex_t() = default;
+
+    copyable_mutex_t(const copyable_mutex_t &) : std::mutex() {
+    }
+
+    copyable_mutex_t &operator=(const copyable_mutex_t &) {
+        return *this;
+    }
+};
+
 // This class holds all the information about a given state space. It utilizes two template types StateTypeT and
 // CostTypeT. These are the basis of the generic implementation as part of requirements 8 and 9.
+// Passed states are kept in hash sets, so besides operator== a state type needs a way to be hashed: a bitwise layout
+// (see is_bitwise_state_v), a std::hash specialization, a state_serializer or a state_hash specialization of its own.
 template<class StateTypeT, class CostTypeT = std::nullptr_t>
 class state_space_t {
 private:
@@ -51,13 +93,110 @@ private:
     std::function<std::list<std::function<void(StateTypeT &)>>(StateTypeT &)> _transitionFunctions;
     std::function<bool(const StateTypeT &)> _invariantFunction;
     std::function<CostTypeT(const StateTypeT &state, const CostTypeT &cost)> _costFunction;
+    std::function<double(const StateTypeT &state)> _heuristicFunction;
     bool _isCostEnabled; // used explicitly to determine whether or not a cost have been specified.
+    std::function<std::uint64_t(const soa_block_t<StateTypeT> &)> _batchInvariant;
+    frontier_layout_t _frontierLayout{node_list};
+    duplicate_detection_t _duplicateDetection{default_detection};
+    std::size_t _chunkSize{0};
+    visited_layout_t _visitedLayout{full_states};
+    bool _isGraphCached{false};
+    // The reachable states and their successors, see enable_graph_cache. It is built by the first search that needs
+    // it and never changed afterwards, so searches share it without locking once they hold it.
+    mutable std::shared_ptr<const explicit_graph_t<StateTypeT>> _graph;
+    mutable copyable_mutex_t _graphMutex;
+    checkpoint_options_t _checkpoint;
+    std::ostream *_memoryReport{nullptr};
+    mutable search_statistics_t _statistics;
+    mutable search_counters_t _counters;
+    mutable copyable_mutex_t _statisticsMutex;
+
+    // Identifies the kind of search in a checkpoint file. The search orders use their enum value, with the flag added
+    // when duplicates are detected as states are generated, as the passed states of the two kinds differ.
+    static constexpr std::uint8_t costCheckpointKind = 0xFF;
+    static constexpr std::uint8_t generatedDuplicatesKind = 0x10;
+
+    bool detectsWhenGenerated(search_order_t order) const {
+        return _duplicateDetection == detect_when_generated ||
+               (_duplicateDetection == default_detection && order == breadth_first);
+    }
+
+    template<class ValidationFunction>
+    std::list<StateTypeT> solveOrder(ValidationFunction isGoalState, search_order_t order) const;
+
+    template<class ValidationFunction>
+    std::list<StateTypeT> solveCost(ValidationFunction isGoalState) const;
+
+    template<class PriorityT, class ValidationFunction, class PriorityFunction>
+    std::list<StateTypeT> solvePriority(ValidationFunction &isGoalState, std::uint8_t kind, PriorityT initial,
+                                        PriorityFunction priorityOf) const;
+
+    double heuristic(const StateTypeT &state) const {
+        return _heuristicFunction ? _heuristicFunction(state) : 0.0;
+    }
+
+    template<class ValidationFunction>
+    std::list<StateTypeT> solveGraph(ValidationFunction isGoalState) const;
+
+    template<class ValidationFunction>
+    std::list<StateTypeT> solveGraphOrder(ValidationFunction isGoalState, search_order_t order) const;
+
+    explicit_graph_t<StateTypeT> buildGraph() const;
+
+    std::shared_ptr<const explicit_graph_t<StateTypeT>> graph() const;
+
+    void setStatistics(const search_statistics_t &statistics) const;
+
+    // Inserts state into passed, counted as the visited phase of the performance counters.
+    template<class PassedT>
+    static bool insertPassed(PassedT &passed, const StateTypeT &state) {
+        perf_phase_t phase(visited_phase);
+        return passed.insert(state);
+    }
 
     template<class ValidationFunction>
-    std::list<StateTypeT> solveOrder(ValidationFunction isGoalState, search_order_t order);
+    std::vector<std::uint8_t> graphGoals(const explicit_graph_t<StateTypeT> &graph,
+                                         ValidationFunction &isGoalState) const;
 
     template<class ValidationFunction>
-    std::list<StateTypeT> solveCost(ValidationFunction isGoalState);
+    std::list<StateTypeT> solveColumns(ValidationFunction isGoalState, search_order_t order) const;
+
+    template<class ValidationFunction>
+    std::list<StateTypeT> solveChunked(ValidationFunction isGoalState) const;
+
+    template<class WaitingListT, class ValidationFunction, class PriorityT, class PriorityFunction>
+    std::list<StateTypeT> solveCollapsed(ValidationFunction &isGoalState, search_order_t order, PriorityT initial,
+                                         PriorityFunction priorityOf) const;
+
+    template<class MatchT>
+    std::vector<std::list<StateTypeT>> solveAll(std::size_t goalCount, MatchT match, search_order_t order,
+                                                const std::function<void(std::size_t, const std::list<StateTypeT> &)>
+                                                &onFound) const;
+
+    template<class ValidationFunction>
+    std::list<StateTypeT> solveBeam(ValidationFunction &isGoalState, std::size_t width,
+                                    const std::function<double(const StateTypeT &)> &score, bool &pruned) const;
+
+    template<class GeneratorT, class ValidationFunction, class EmitT>
+    void expand(GeneratorT &generator, StateTypeT &state, ValidationFunction &isGoalState,
+                expansion_scratch_t<StateTypeT> &scratch, EmitT emit) const;
+
+    template<class SearchT, class ValidationFunction>
+    void markBatchGoals(SearchT &search, ValidationFunction &isGoalState) const;
+
+    template<class SearchT, class ValidationFunction>
+    bool reachedGoal(SearchT &search, const trace_node<StateTypeT> *traceState,
+                     ValidationFunction &isGoalState) const;
+
+    template<class SearchT>
+    void beginSearch(std::uint8_t kind, SearchT &search,
+                     const typename SearchT::waiting_element_t &startElement) const;
+
+    template<class SearchT>
+    void checkpointIfDue(std::uint8_t kind, SearchT &search) const;
+
+    template<class SearchT>
+    void endSearch(SearchT &search) const;
 
 public:
     // This is the first constructor for the class, which handles calls from the frogs.cpp
@@ -93,8 +232,187 @@ public:
                                                                           true) {
     }
 
+    // Searches for a state satisfying isGoalState and returns the trace from the start state to it, or an empty list.
+    // check, check_all and check_backward only read the state space, so any number of threads can call them at once
+    // on one state space, as long as none of the set_ and enable_ methods is called meanwhile and no checkpoint is
+    // enabled. Each search takes its working memory from the scratch_pool_t of its thread and returns it there, so
+    // repeated searches on a thread reuse the memory of the earlier ones.
     template<class ValidationFunction>
-    std::list<StateTypeT> check(ValidationFunction isGoalState, search_order_t order = search_order_t::breadth_first);
+    std::list<StateTypeT> check(ValidationFunction isGoalState,
+                                search_order_t order = search_order_t::breadth_first) const;
+
+    // Called by check_all with the position of a goal and its trace, as soon as the goal is reached.
+    using found_callback_t = std::function<void(std::size_t goal, const std::list<StateTypeT> &trace)>;
+
+    // Answers several goal questions with one traversal. Every state taken from waiting is checked against the goals
+    // that have not been reached yet, and the search stops once all goals are reached or the state space is
+    // exhausted. The traversal is the one of check(), so each trace is the one check() would return for that goal
+    // alone. Searches greedy best first when that order is given, otherwise by cost when a cost function is given and
+    // else in the given order. Returns the traces in the order of the goals, with an empty trace for every goal that
+    // cannot be reached.
+    std::vector<std::list<StateTypeT>> check_all(const std::vector<std::function<bool(const StateTypeT &)>> &goals,
+                                                 search_order_t order = search_order_t::breadth_first,
+                                                 const found_callback_t &onFound = {}) const;
+
+    // The same for goals given as concrete target states. The targets are kept in a hash table, so checking a state
+    // costs one lookup however many targets there are.
+    std::vector<std::list<StateTypeT>> check_all(const std::vector<StateTypeT> &targets,
+                                                 search_order_t order = search_order_t::breadth_first,
+                                                 const found_callback_t &onFound = {}) const;
+
+    // Searches breadth first, but keeps only the width best new states of every depth, so the memory stays within
+    // width times the depth of the search. The states are ranked by score, lowest first, or by the cost function when
+    // no score is given, or else kept in the order they are generated. States kept at an earlier depth are not kept
+    // again. The goal is checked as the states of a depth are expanded, and the trace need not be the shortest.
+    // When no goal is found although states were dropped, the search is repeated with twice the width, as long as
+    // the width stays within maxWidth. A width of zero is taken as one.
+    template<class ValidationFunction>
+    std::list<StateTypeT> check_beam(ValidationFunction isGoalState, std::size_t width, std::size_t maxWidth = 0,
+                                     const std::function<double(const StateTypeT &)> &score = {}) const;
+
+    // Installs a batch version of the invariant, which is then used instead of the invariant function to check the
+    // successors of each expansion a block at a time. It must agree with the invariant function, which is still used
+    // where states are checked one by one. Requires a state_columns specialization for StateTypeT.
+    void set_batch_invariant(batch_predicate_t<StateTypeT> batchInvariant) {
+        _batchInvariant = std::move(batchInvariant);
+        _graph.reset();
+    }
+
+    // Replaces the start state, so that one state space can solve several instances of the model. The cached graph
+    // belongs to the old start state and is dropped.
+    void set_start_state(StateTypeT startState) {
+        if (!state_equal<StateTypeT>{}(_startState, startState)) {
+            _startState = std::move(startState);
+            _graph.reset();
+        }
+    }
+
+    // Sets the heuristic of greedy best first searches, an estimate of how far a state is from the goal. Such searches
+    // ignore the cost function and take the waiting state with the lowest estimate first, states with equal estimates
+    // in the order they were generated, so without a heuristic they search breadth first. The traces need not be the
+    // shortest.
+    void set_heuristic(std::function<double(const StateTypeT &state)> heuristicFunction) {
+        _heuristicFunction = std::move(heuristicFunction);
+    }
+
+    // Replaces the cost function, so that one state space can be searched with several costs.
+    void set_cost(std::function<CostTypeT(const StateTypeT &state, const CostTypeT &cost)> costFunction) {
+        _costFunction = std::move(costFunction);
+        _isCostEnabled = true;
+    }
+
+    // Makes searches keep the explicit state graph: the first search enumerates all reachable states and their valid
+    // successors, and every cost, breadth first and depth first search then runs over that graph without calling the
+    // transitions or the invariant again. This pays off when the same space is searched for different goals or with
+    // different cost functions, see set_cost. The whole reachable space is held in memory. Searches with checkpoints
+    // enabled do not use the graph, and the frontier layout, the visited layout and the chunk size do not apply to it:
+    // the graph keeps every state in full once and marks the passed ones by number.
+    void enable_graph_cache(bool enabled = true) {
+        _isGraphCached = enabled;
+        if (!enabled) {
+            _graph.reset();
+        }
+    }
+
+    // Selects how breadth and depth first searches store their waiting states. With column_arrays they are kept in a
+    // soa_frontier_t instead of trace_nodes, which needs a state_columns specialization with unpack. Searches with
+    // checkpoints enabled always use the node list.
+    void set_frontier_layout(frontier_layout_t layout) {
+        _frontierLayout = layout;
+    }
+
+    // Selects when breadth and depth first searches detect duplicate states, see duplicate_detection_t. Either way
+    // breadth first searches report the same traces, as the first copy of a state in waiting is the one that is
+    // expanded, but detecting them when generated keeps fewer states in waiting. Backward searches are breadth first
+    // and follow the same setting.
+    void set_duplicate_detection(duplicate_detection_t detection) {
+        _duplicateDetection = detection;
+    }
+
+    // Makes breadth first searches expand chunkSize waiting states at a time, running each step over the whole chunk
+    // before the next: generating all successors, hashing them, probing the visited set, checking the invariant and
+    // appending the new states. Duplicates are detected when states are generated, using state_hash. Zero, the
+    // default, expands one state at a time. Depth first and cost searches and searches with checkpoints are not
+    // affected.
+    void set_chunk_size(std::size_t chunkSize) {
+        _chunkSize = chunkSize;
+    }
+
+    // Selects how the passed states are stored. With collapsed_states each state is cut into parts as described by
+    // collapse_layout, and only the indices of its interned parts are kept, which takes far less memory when many
+    // states share parts. Searches without checkpoints then also keep their trace nodes as indices of the interned
+    // states, see collapsed_search_state_t, so no state is kept in full at all. Only states with a collapse_layout
+    // whose bytes determine their value can be collapsed, others are kept in full.
+    // The chunked breadth first search, persistent searches and the cached graph keep their own visited sets and are
+    // not affected.
+    void set_visited_layout(visited_layout_t layout) {
+        if (layout == collapsed_states && !passed_set_t<StateTypeT>::collapsible) {
+            std::cerr << "Collapse compression is not supported for this state type" << std::endl;
+        }
+        _visitedLayout = layout;
+    }
+
+    // Searches breadth first from the goalStates towards the start state using predecessorFunctions, which generates
+    // the transitions leading into a state, i.e. the inverse of the successor generator. This pays off when the goal
+    // side of the space branches much less than the start side. The invariant is checked on every predecessor.
+    // Returns the trace in forward order, from the start state to one of the goal states, or an empty list.
+    std::list<StateTypeT> check_backward(
+            std::function<std::list<std::function<void(StateTypeT &)>>(StateTypeT &)> predecessorFunctions,
+            const std::list<StateTypeT> &goalStates) const;
+
+    // Answers isGoalState with a breadth first search whose visited states are kept in a memory mapped file at path,
+    // so that later runs can reuse them. The modelTag names the model (and anything else the transitions depend on),
+    // and together with the start state it decides whether an existing file belongs to this space. Stored states are
+    // scanned first, and only if none of them is a goal is the exploration extended, starting from where the previous
+    // run stopped. Once a model is explored completely, queries are answered from the file without calling the
+    // transitions at all. Costs are ignored. Requires a state_serializer for StateTypeT with a fixed serialized size.
+    template<class ValidationFunction>
+    std::list<StateTypeT> check_persistent(ValidationFunction isGoalState, const std::string &path,
+                                           const std::string &modelTag);
+
+    // Enumerates every reachable state breadth first and writes the state graph to path in the format of
+    // state_graph.hpp: the packed states numbered in the order they were found, and for every state the numbers of
+    // its successors that satisfy the invariant. The visited states are kept in a memory mapped store next to the
+    // output and the successors are streamed to disk, so the exploration is not limited by memory. Costs are ignored.
+    // Requires a state_serializer for StateTypeT with a fixed serialized size. Returns false if the graph could not be
+    // written.
+    bool explore_all(const std::string &path);
+
+    // Enumerates every state of StateTypeT once, reachable or not, and returns its validity and the ranks of its valid
+    // successors as a compiled_space_t, whose breadth first queries then need neither the transitions nor the
+    // invariant. Costs are ignored. Requires a state_rank specialization for StateTypeT, so only pays off for models
+    // small enough to be numbered densely.
+    compiled_space_t<StateTypeT> compile() const;
+
+    // Makes check() save its search to path every interval expansions (never if interval is zero) and whenever
+    // checkpoint_requested is set, e.g. by checkpoint_signal_handler. If a checkpoint for the same kind of search and
+    // start state exists at path when check() is called, the search continues from it instead of starting over.
+    // The file is removed when the search finishes.
+    void enable_checkpoint(const std::string &path, std::size_t interval = 0) {
+        _checkpoint = checkpoint_options_t{path, interval};
+    }
+
+    // Makes check() print a memory_report() to out when it finishes, or stops it when out is null. The figures are for
+    // the whole process, so with concurrent searches they include the memory of the others. The peaks are reset
+    // before each search, so the peaks reported are those of the search.
+    void set_memory_report(std::ostream *out) {
+        _memoryReport = out;
+    }
+
+    // Returns the counters of the last call to check(). When searches run concurrently, these are the counters of the
+    // search that finished last.
+    search_statistics_t statistics() const {
+        std::lock_guard<std::mutex> lock(_statisticsMutex);
+        return _statistics;
+    }
+
+    // Returns the hardware performance counters of the last call to check() per search phase, see perf_counters.hpp.
+    // They are only available when compiled with PUZZLEENGINE_PERF_COUNTERS. The transitions and the invariant are
+    // counted in every search, the visited lookups and the operations on waiting in the searches over trace_nodes.
+    search_counters_t counters() const {
+        std::lock_guard<std::mutex> lock(_statisticsMutex);
+        return _counters;
+    }
 };
 
 // This function is called from the different puzzle files and returns a solution if found. It introduces a new template
@@ -103,44 +421,386 @@ public:
 // It returns a list of states.
 template<class StateTypeT, class CostTypeT>
 template<class ValidationFunction>
-std::list<StateTypeT> state_space_t<StateTypeT, CostTypeT>::check(ValidationFunction isGoalState, search_order_t order) {
+std::list<StateTypeT>
+state_space_t<StateTypeT, CostTypeT>::check(ValidationFunction isGoalState, search_order_t order) const {
     std::list<StateTypeT> solution;
+    if (_memoryReport != nullptr) {
+        reset_memory_peaks();
+    }
+#ifdef PUZZLEENGINE_PERF_COUNTERS
+    perf_recorder_t::thread().begin();
+#endif
+    trace_span_t span("search", "check", "trace");
 
-    if (_isCostEnabled) { // Here we check if the cost method is specified, and calls the solveCost if true.
+    if (order == greedy_best_first) { // The heuristic takes the place of any cost.
+        solution = solvePriority(isGoalState, static_cast<std::uint8_t>(order), heuristic(_startState),
+                                 [this](const StateTypeT &successor, double) { return heuristic(successor); });
+    } else if constexpr (std::is_same<CostTypeT, std::nullptr_t>::value) { // Without a cost type only orders remain.
+        solution = solveOrder(isGoalState, order);
+    } else if (_isCostEnabled) { // Here we check if the cost method is specified, and calls the solveCost if true.
         solution = solveCost(isGoalState);
     } else { // Otherwise we call the solveOrder method with the order provided.
         solution = solveOrder(isGoalState, order);
     }
+    span.set_value(solution.size());
+    span.end();
+
+#ifdef PUZZLEENGINE_PERF_COUNTERS
+    {
+        const auto &counters = perf_recorder_t::thread().end();
+        std::lock_guard<std::mutex> lock(_statisticsMutex);
+        _counters = counters;
+    }
+#endif
+    if (_memoryReport != nullptr) {
+        *_memoryReport << memory_report();
+    }
 
     // Returns the list of states. Implemented as part of requirement 4.
     return solution;
 }
 
+template<class StateTypeT, class CostTypeT>
+template<class ValidationFunction>
+std::list<StateTypeT>
+state_space_t<StateTypeT, CostTypeT>::check_beam(ValidationFunction isGoalState, std::size_t width,
+                                                 std::size_t maxWidth,
+                                                 const std::function<double(const StateTypeT &)> &score) const {
+    width = std::max<std::size_t>(width, 1); // a width of zero would keep nothing and never stop widening
+    auto pruned = false;
+    auto solution = solveBeam(isGoalState, width, score, pruned);
+    while (solution.empty() && pruned && width < maxWidth) {
+        width = std::min(width * 2, maxWidth);
+        solution = solveBeam(isGoalState, width, score, pruned);
+    }
+    return solution;
+}
+
+// The goals that are not reached yet are kept in a list, so each of them is checked until it is reached and then no more.
+template<class StateTypeT, class CostTypeT>
+std::vector<std::list<StateTypeT>> state_space_t<StateTypeT, CostTypeT>::check_all(
+        const std::vector<std::function<bool(const StateTypeT &)>> &goals, search_order_t order,
+        const found_callback_t &onFound) const {
+    std::vector<std::size_t> open(goals.size());
+    std::iota(open.begin(), open.end(), 0);
+    return solveAll(goals.size(), [&goals, &open](const StateTypeT &state, auto &&reached) {
+        for (auto goal = open.begin(); goal != open.end();) {
+            if (goals[*goal](state)) {
+                reached(*goal);
+                goal = open.erase(goal);
+            } else {
+                ++goal;
+            }
+        }
+    }, order, onFound);
+}
+
+// A target that occurs several times in targets answers all of its positions at once.
+template<class StateTypeT, class CostTypeT>
+std::vector<std::list<StateTypeT>> state_space_t<StateTypeT, CostTypeT>::check_all(
+        const std::vector<StateTypeT> &targets, search_order_t order, const found_callback_t &onFound) const {
+    std::unordered_map<StateTypeT, std::vector<std::size_t>, state_hash<StateTypeT>, state_equal<StateTypeT>> open;
+    for (std::size_t goal = 0; goal < targets.size(); ++goal) {
+        open[targets[goal]].push_back(goal);
+    }
+    return solveAll(targets.size(), [&open](const StateTypeT &state, auto &&reached) {
+        auto target = open.find(state);
+        if (target != open.end()) {
+            for (auto goal: target->second) {
+                reached(goal);
+            }
+            open.erase(target);
+        }
+    }, order, onFound);
+}
+
+// The method is the mirror image of solveOrder with breadth first order. The waiting list is seeded with all goal states
+// and a state is done when it equals the start state. Since the trace_nodes point from each state towards the goal it
+// was reached from, following them from the start state already gives the trace in forward order.
+template<class StateTypeT, class CostTypeT>
+std::list<StateTypeT> state_space_t<StateTypeT, CostTypeT>::check_backward(
+        std::function<std::list<std::function<void(StateTypeT &)>>(StateTypeT &)> predecessorFunctions,
+        const std::list<StateTypeT> &goalStates) const {
+    StateTypeT currentState{_startState};
+    trace_node<StateTypeT> *traceState {};
+    std::list<StateTypeT> solution;
+    auto scratch = scratch_pool_t<search_state_t<StateTypeT, trace_node<StateTypeT> *>>::acquire();
+    auto &search = *scratch;
+    auto &passed = search.passed;
+    auto &waiting = search.waiting;
+    auto &expansion = search.expansion;
+    trace_span_t span("search", "check_backward");
+
+    const auto early = detectsWhenGenerated(breadth_first);
+    passed.set_layout(_visitedLayout);
+    for (auto &goalState: goalStates) {
+        if (!early || passed.insert(goalState)) {
+            waiting.push_back(search.addTrace(nullptr, goalState));
+        }
+    }
+
+    while (!waiting.empty()) {
+        currentState = waiting.front()->selfState;
+        traceState = waiting.front();
+        waiting.pop_front();
+
+        if (state_equal<StateTypeT>{}(currentState, _startState)) {
+            for (; traceState != nullptr; traceState = traceState->parentState) {
+                solution.push_back(traceState->selfState);
+            }
+            break;
+        }
+        if (early || passed.insert(currentState)) {
+            ++search.statistics.expanded;
+
+            auto noGoal = [](const StateTypeT &) { return false; };
+            expand(predecessorFunctions, currentState, noGoal, expansion, [&](const StateTypeT &predecessor, bool) {
+                if (early && !passed.insert(predecessor)) {
+                    return;
+                }
+                waiting.push_back(search.addTrace(traceState, predecessor));
+                ++search.statistics.generated;
+            });
+        }
+    }
+
+    setStatistics(search.statistics);
+    return solution;
+}
+
+// The method looks for a goal among the states stored at path and extends the stored exploration until one is found or
+// the whole state space is stored. The records of the store are in breadth first order, so the first goal found
+// is reached by a shortest trace, which is rebuilt by following the parent records.
+template<class StateTypeT, class CostTypeT>
+template<class ValidationFunction>
+std::list<StateTypeT>
+state_space_t<StateTypeT, CostTypeT>::check_persistent(ValidationFunction isGoalState, const std::string &path,
+                                                       const std::string &modelTag) {
+    std::list<StateTypeT> solution;
+    if constexpr (!state_serializer<StateTypeT>::supported) {
+        std::cerr << "Persistent visited sets are not supported for this state type" << std::endl;
+        return solution;
+    } else {
+        std::string key;
+        pack_state(_startState, key);
+        const auto width = key.size();
+        const auto fingerprint = mmap_visited_set_t::hash(key.data(), width, mmap_visited_set_t::hash(
+                modelTag.data(), modelTag.size()));
+        mmap_visited_set_t store;
+        search_statistics_t statistics;
+        StateTypeT currentState{_startState};
+        auto found = mmap_visited_set_t::npos;
+
+        // Checks the stored states from index first on and returns the first goal among them.
+        auto scan = [&](std::size_t first) {
+            for (auto index = first; index < store.size(); ++index) {
+                unpack_state(store.key(index), width, currentState);
+                if (isGoalState(currentState)) {
+                    return static_cast<std::uint32_t>(index);
+                }
+            }
+            return mmap_visited_set_t::npos;
+        };
+
+        // A store that already exists is opened read-only first, as it may answer the query without any exploration.
+        std::size_t scanned = 0;
+        if (store.open(path, fingerprint, width, mmap_visited_set_t::open_mode_t::read_only)) {
+            found = scan(0);
+            scanned = store.size();
+            if (found == mmap_visited_set_t::npos && store.complete()) {
+                setStatistics(statistics);
+                return solution;
+            }
+        }
+        if (found == mmap_visited_set_t::npos) {
+            if (!store.open(path, fingerprint, width, mmap_visited_set_t::open_mode_t::read_write)) {
+                std::cerr << "Could not open visited store " << path << std::endl;
+                return solution;
+            }
+            // The shared lock was released in between, so another process may have replaced the store. Records are
+            // only ever appended to a store, so one that is smaller than before is a new store and is scanned anew.
+            if (store.size() < scanned) {
+                scanned = 0;
+            }
+            if (store.size() == 0) {
+                store.insert(key.data(), mmap_visited_set_t::npos, 0);
+            }
+            found = scan(scanned);
+        }
+
+        // Here the stored frontier is expanded in order. Successors are checked against the goal when they are stored,
+        // but the expansion is always finished, so that every record before expanded() has all its successors stored.
+        while (found == mmap_visited_set_t::npos && store.expanded() < store.size()) {
+            const auto index = static_cast<std::uint32_t>(store.expanded());
+            const auto depth = store.depth(index);
+            unpack_state(store.key(index), width, currentState);
+            ++statistics.expanded;
+
+            for (auto transition: _transitionFunctions(currentState)) {
+                auto successor{currentState};
+                transition(successor);
+
+                if (!_invariantFunction(successor)) {
+                    continue;
+                }
+                pack_state(successor, key);
+                if (key.size() != width) {
+                    std::cerr << "States of varying size cannot be stored in " << path << std::endl;
+                    return solution;
+                }
+                auto inserted = store.insert(key.data(), index, depth + 1);
+                if (inserted.first == mmap_visited_set_t::npos) {
+                    std::cerr << "Could not extend visited store " << path << std::endl;
+                    return solution;
+                }
+                if (inserted.second) {
+                    ++statistics.generated;
+                    if (found == mmap_visited_set_t::npos && isGoalState(successor)) {
+                        found = inserted.first;
+                    }
+                }
+            }
+            store.set_expanded(index + 1);
+        }
+
+        // The trace is rebuilt from the goal by following the parent records back to the start state.
+        for (auto index = found; index != mmap_visited_set_t::npos; index = store.parent(index)) {
+            unpack_state(store.key(index), width, currentState);
+            solution.push_front(currentState);
+        }
+        setStatistics(statistics);
+        return solution;
+    }
+}
+
+// The method takes the records of the visited store in order, like check_persistent, so a state's number is its record.
+// Every successor, new or not, becomes an edge to the record of its key.
+template<class StateTypeT, class CostTypeT>
+bool state_space_t<StateTypeT, CostTypeT>::explore_all(const std::string &path) {
+    if constexpr (!state_serializer<StateTypeT>::supported) {
+        std::cerr << "Exploring to a file is not supported for this state type" << std::endl;
+        return false;
+    } else {
+        std::string key;
+        pack_state(_startState, key);
+        const auto width = key.size();
+        const auto storePath = path + ".visited";
+        mmap_visited_set_t store;
+        state_graph_writer_t graph(path);
+        search_statistics_t statistics;
+        StateTypeT currentState{_startState};
+
+        // The store only serves this exploration, so it is always started empty and removed at the end.
+        std::remove(storePath.c_str());
+        if (!store.open(storePath, 0, width, mmap_visited_set_t::open_mode_t::read_write) || !graph.good()) {
+            std::cerr << "Could not create " << storePath << " or the files next to " << path << std::endl;
+            return false;
+        }
+        store.insert(key.data(), mmap_visited_set_t::npos, 0);
+
+        bool valid = true;
+        for (std::uint32_t index = 0; valid && index < store.size(); ++index) {
+            unpack_state(store.key(index), width, currentState);
+            graph.begin_state();
+            ++statistics.expanded;
+
+            for (auto transition: _transitionFunctions(currentState)) {
+                auto successor{currentState};
+                transition(successor);
+
+                if (!_invariantFunction(successor)) {
+                    continue;
+                }
+                pack_state(successor, key);
+                if (key.size() != width) {
+                    std::cerr << "States of varying size cannot be written to " << path << std::endl;
+                    valid = false;
+                    break;
+                }
+                auto inserted = store.insert(key.data(), index, store.depth(index) + 1);
+                if (inserted.first == mmap_visited_set_t::npos) {
+                    std::cerr << "Could not extend visited store " << storePath << std::endl;
+                    valid = false;
+                    break;
+                }
+                statistics.generated += inserted.second;
+                graph.add_edge(inserted.first);
+            }
+        }
+
+        valid = valid && graph.finish(store.size(), width, [&store](std::uint64_t index) {
+            return store.key(static_cast<std::uint32_t>(index));
+        });
+        if (!valid) {
+            std::cerr << "Could not write state graph " << path << std::endl;
+        }
+        store.close();
+        std::remove(storePath.c_str());
+        setStatistics(statistics);
+        return valid;
+    }
+}
+
 // The method is used when solving the state space based on a given cost. It takes in isGoalState which is a predicate
 // that is used to determine whether a solution have been found.
 // It returns a list of states. It is implemented as part of requirement 7.
 template<class StateTypeT, class CostTypeT>
 template<class ValidationFunction>
-std::list<StateTypeT> state_space_t<StateTypeT, CostTypeT>::solveCost(ValidationFunction isGoalState) {
+std::list<StateTypeT> state_space_t<StateTypeT, CostTypeT>::solveCost(ValidationFunction isGoalState) const {
+    if (_isGraphCached && _checkpoint.path.empty()) {
+        return solveGraph(isGoalState);
+    }
+    return solvePriority(isGoalState, costCheckpointKind, _initialCost,
+                         [this](const StateTypeT &successor, const CostTypeT &cost) {
+                             return _costFunction(successor, cost);
+                         });
+}
+
+// The method runs the searches that take the waiting state with the lowest priority first: the cost searches, where
+// priorityOf(successor, priority) is the cost function, and the greedy best first searches, where it is the heuristic.
+// The kind identifies the search in checkpoints.
+template<class StateTypeT, class CostTypeT>
+template<class PriorityT, class ValidationFunction, class PriorityFunction>
+std::list<StateTypeT>
+state_space_t<StateTypeT, CostTypeT>::solvePriority(ValidationFunction &isGoalState, std::uint8_t kind,
+                                                    PriorityT initial, PriorityFunction priorityOf) const {
+    if constexpr (passed_set_t<StateTypeT>::collapsible) {
+        if (_visitedLayout == collapsed_states && _checkpoint.path.empty()) {
+            return solveCollapsed<open_list_for_t<PriorityT, std::uint32_t>>(isGoalState, greedy_best_first, initial,
+                                                                             priorityOf);
+        }
+    }
+    using waiting_t = std::pair<PriorityT, trace_node<StateTypeT> *>;
     StateTypeT currentState;
-    CostTypeT itCost{_initialCost}, newCost;
+    PriorityT itCost{initial}, newCost;
     trace_node<StateTypeT> *traceState {};
-    std::list<StateTypeT> passed, solution;
-    std::list<std::pair<CostTypeT, trace_node<StateTypeT> *>> waiting;
+    std::list<StateTypeT> solution;
+    using search_t = search_state_t<StateTypeT, waiting_t, open_list_for_t<PriorityT, trace_node<StateTypeT> *>>;
+    auto scratch = scratch_pool_t<search_t>::acquire();
+    auto &search = *scratch;
+    auto &expansion = search.expansion;
+    auto &passed = search.passed;
+    auto &waiting = search.waiting;
 
-    // The method utilizes a waiting list that contains a pair of cost and a trace_node. The cost is used to determine
-    // which element should be popped from the list next.
-    waiting.push_back(std::make_pair(itCost, new trace_node<StateTypeT>{nullptr, _startState}));
+    // The method utilizes an open list of pairs of cost and trace_node as waiting list. The cost is used to determine
+    // which element should be popped next, see open_list_for_t for how the open list is chosen. The list starts out
+    // with the start state, unless the search is continued from a checkpoint.
+    beginSearch(kind, search, waiting_t{itCost, nullptr});
+    markBatchGoals(search, isGoalState);
+    expansion_trace_t expansions;
 
     while (!waiting.empty()) {
-        // Here we take the first element from the list and then pop it.
-        currentState = waiting.front().second->selfState;
-        traceState = waiting.front().second;
-        itCost = waiting.front().first;
-        waiting.pop_front();
+        // Here we pop the element with the lowest cost.
+        auto element = [&waiting]() {
+            perf_phase_t phase(frontier_phase);
+            return waiting.pop();
+        }();
+        currentState = element.second->selfState;
+        traceState = element.second;
+        itCost = element.first;
 
         // Here we check if the goal state has been reached. This is implemented as part of requirement 3.
-        if (isGoalState(currentState)) {
+        if (reachedGoal(search, traceState, isGoalState)) {
             // If a goal is found, we use the traceState to traverse back up through the tree of trace_nodes
             // until the parentState is NULL. For each node we push the state to the solution list.
             while (traceState->parentState != NULL) {
@@ -149,37 +809,456 @@ std::list<StateTypeT> state_space_t<StateTypeT, CostTypeT>::solveCost(Validation
             }
 
             solution.push_front(traceState->selfState); // Adds the start state to the solution trace.
+            endSearch(search);
             return solution;
         }
 
-        // Here we check if the currentState is part of the passed list.
-        if (!(std::find(passed.begin(), passed.end(), currentState) != passed.end())) {
-            // If it is not, we push it to the list, and generate the transitions via the _transitionFunctions which
-            // is a member of the state_space_t class.
-            passed.push_back(currentState);
-            auto transitions = _transitionFunctions(currentState);
+        // Here we add the currentState to the passed states, unless it is part of them already.
+        if (insertPassed(passed, currentState)) {
+            // If it was not, we generate the transitions via the _transitionFunctions which is a member of the
+            // state_space_t class.
+            ++search.statistics.expanded;
+            expansions.expanded();
 
-            for (auto transition: transitions) {
-                // For each transition, we then generate the successor
-                auto successor{currentState};
-                transition(successor);
+            // For each transition, we then generate the successor. Invalid states are prevented from being added to
+            // waiting via an invariant predicate, which expand applies. This is implemented as part of requirement 6.
+            expand(_transitionFunctions, currentState, isGoalState, expansion,
+                   [&](const StateTypeT &successor, bool goal) {
+                newCost = priorityOf(successor, itCost);
+                perf_phase_t phase(frontier_phase);
+                auto *node = search.addTrace(traceState, successor);
+                if (goal) {
+                    search.batchGoals.insert(node);
+                }
+                waiting.push(newCost, node);
+                ++search.statistics.generated;
+            });
+            checkpointIfDue(kind, search);
+        }
+    }
 
-                // Prevents invalid states being added to waiting via an invariant predicate. This is implemented as
-                // part of requirement 6.
-                if (!_invariantFunction(successor)) {
-                    continue;
+    endSearch(search);
+    return solution;
+}
+
+// The method expands the search a depth at a time. The kept states are numbered in the order they were kept, and the
+// states of a depth are the ones between first and last. Their successors are ranked with a stable sort, so equally
+// ranked states are kept in the order they were generated, and only the width best of the ones not kept before are
+// kept for the next depth. pruned tells whether any new state was dropped.
+template<class StateTypeT, class CostTypeT>
+template<class ValidationFunction>
+std::list<StateTypeT>
+state_space_t<StateTypeT, CostTypeT>::solveBeam(ValidationFunction &isGoalState, std::size_t width,
+                                                const std::function<double(const StateTypeT &)> &score,
+                                                bool &pruned) const {
+    struct candidate_t {
+        StateTypeT state;
+        std::uint32_t parent;
+        CostTypeT cost;
+        double score;
+    };
+    constexpr bool hasCost = !std::is_same<CostTypeT, std::nullptr_t>::value;
+    constexpr auto none = std::numeric_limits<std::uint32_t>::max();
+    std::list<StateTypeT> solution;
+    search_statistics_t statistics;
+    hash_visited_set_t<StateTypeT> kept;
+    std::vector<std::uint32_t> parents{none};
+    std::vector<CostTypeT> costs{_initialCost};
+    std::vector<candidate_t> candidates;
+    expansion_scratch_t<StateTypeT> expansion;
+    StateTypeT currentState{_startState};
+    auto noGoal = [](const StateTypeT &) { return false; };
+
+    pruned = false;
+    kept.insert(_startState);
+    for (std::size_t first = 0, last = 1; first < last; first = last, last = kept.size()) {
+        candidates.clear();
+        for (auto index = first; index < last; ++index) {
+            currentState = kept.states()[index];
+            if (isGoalState(currentState)) {
+                for (auto node = static_cast<std::uint32_t>(index); node != none; node = parents[node]) {
+                    solution.push_front(kept.states()[node]);
                 }
-                newCost = _costFunction(successor, itCost);
-                waiting.push_back(std::make_pair(newCost, new trace_node<StateTypeT>{traceState, successor}));
+                setStatistics(statistics);
+                return solution;
             }
-            if (!transitions.empty()) { // Prevents sorting if no new transitions have been found.
-                // Here we sort the waiting list based on the cost for each pair in the list.
-                waiting.sort([](const std::pair<CostTypeT, trace_node<StateTypeT> *> &a,
-                                std::pair<CostTypeT, trace_node<StateTypeT> *> &b) { return a.first < b.first; });
+            ++statistics.expanded;
+            expand(_transitionFunctions, currentState, noGoal, expansion, [&](const StateTypeT &successor, bool) {
+                auto cost = costs[index];
+                if constexpr (hasCost) {
+                    if (_isCostEnabled) {
+                        cost = _costFunction(successor, costs[index]);
+                    }
+                }
+                candidates.push_back({successor, static_cast<std::uint32_t>(index), cost,
+                                      score ? score(successor) : 0.0});
+            });
+        }
+
+        if (score) {
+            std::stable_sort(candidates.begin(), candidates.end(), [](const candidate_t &a, const candidate_t &b) {
+                return a.score < b.score;
+            });
+        } else if constexpr (hasCost) {
+            if (_isCostEnabled) {
+                std::stable_sort(candidates.begin(), candidates.end(), [](const candidate_t &a, const candidate_t &b) {
+                    return a.cost < b.cost;
+                });
+            }
+        }
+        for (auto &candidate: candidates) {
+            if (kept.size() - last == width) {
+                pruned = pruned || !kept.contains(candidate.state);
+            } else if (kept.insert(candidate.state)) {
+                parents.push_back(candidate.parent);
+                costs.push_back(candidate.cost);
+                ++statistics.generated;
             }
         }
     }
 
+    setStatistics(statistics);
+    return solution;
+}
+
+// The method runs the traversal of check_all. match(state, reached) calls reached with every goal that state
+// satisfies and that was not reached before. Goals are checked when states are taken from waiting, as in solveOrder
+// and solveCost, and the trace of each goal is built from the trace_nodes right away.
+template<class StateTypeT, class CostTypeT>
+template<class MatchT>
+std::vector<std::list<StateTypeT>>
+state_space_t<StateTypeT, CostTypeT>::solveAll(std::size_t goalCount, MatchT match, search_order_t order,
+                                               const std::function<void(std::size_t, const std::list<StateTypeT> &)>
+                                               &onFound) const {
+    std::vector<std::list<StateTypeT>> solutions(goalCount);
+    std::size_t found = 0;
+    StateTypeT currentState{_startState};
+    trace_span_t span("search", "check_all", "goals", goalCount);
+    auto noGoal = [](const StateTypeT &) { return false; };
+
+    // Checks the state of traceState against the goals. Returns whether all goals are reached now.
+    auto visit = [&](const trace_node<StateTypeT> *traceState) {
+        match(traceState->selfState, [&](std::size_t goal) {
+            for (auto *node = traceState; node != nullptr; node = node->parentState) {
+                solutions[goal].push_front(node->selfState);
+            }
+            ++found;
+            if (onFound) {
+                onFound(goal, solutions[goal]);
+            }
+        });
+        return found == goalCount;
+    };
+
+    if (goalCount == 0) {
+        return solutions;
+    }
+
+    // Cost and greedy best first searches take the waiting state with the lowest priority first, as in solvePriority.
+    auto searchByPriority = [&](auto initial, auto priorityOf) {
+        using waiting_t = std::pair<decltype(initial), trace_node<StateTypeT> *>;
+        using search_t = search_state_t<StateTypeT, waiting_t,
+                                        open_list_for_t<decltype(initial), trace_node<StateTypeT> *>>;
+        auto scratch = scratch_pool_t<search_t>::acquire();
+        auto &search = *scratch;
+        auto &expansion = search.expansion;
+        search.passed.set_layout(_visitedLayout);
+        search.waiting.push(initial, search.addTrace(nullptr, _startState));
+        while (!search.waiting.empty()) {
+            auto element = search.waiting.pop();
+            if (visit(element.second)) {
+                break;
+            }
+            if (search.passed.insert(element.second->selfState)) {
+                ++search.statistics.expanded;
+                currentState = element.second->selfState;
+                expand(_transitionFunctions, currentState, noGoal, expansion, [&](const StateTypeT &successor, bool) {
+                    search.waiting.push(priorityOf(successor, element.first),
+                                        search.addTrace(element.second, successor));
+                    ++search.statistics.generated;
+                });
+            }
+        }
+        setStatistics(search.statistics);
+    };
+
+    if (order == greedy_best_first) {
+        searchByPriority(heuristic(_startState),
+                         [this](const StateTypeT &successor, double) { return heuristic(successor); });
+        return solutions;
+    }
+    if constexpr (!std::is_same<CostTypeT, std::nullptr_t>::value) {
+        if (_isCostEnabled) {
+            searchByPriority(_initialCost, [this](const StateTypeT &successor, const CostTypeT &cost) {
+                return _costFunction(successor, cost);
+            });
+            return solutions;
+        }
+    }
+
+    if (order != breadth_first && order != depth_first) {
+        std::cout << "Order not supported" << std::endl;
+        return solutions;
+    }
+    auto scratch = scratch_pool_t<search_state_t<StateTypeT, trace_node<StateTypeT> *>>::acquire();
+    auto &search = *scratch;
+    auto &expansion = search.expansion;
+    auto &waiting = search.waiting;
+    const auto early = detectsWhenGenerated(order);
+    search.passed.set_layout(_visitedLayout);
+    if (early) {
+        search.passed.insert(_startState);
+    }
+    waiting.push_back(search.addTrace(nullptr, _startState));
+    while (!waiting.empty()) {
+        auto *traceState = order == breadth_first ? waiting.front() : waiting.back();
+        if (order == breadth_first) {
+            waiting.pop_front();
+        } else {
+            waiting.pop_back();
+        }
+        if (visit(traceState)) {
+            break;
+        }
+        if (early || search.passed.insert(traceState->selfState)) {
+            ++search.statistics.expanded;
+            currentState = traceState->selfState;
+            expand(_transitionFunctions, currentState, noGoal, expansion, [&](const StateTypeT &successor, bool) {
+                if (early && !search.passed.insert(successor)) {
+                    return;
+                }
+                waiting.push_back(search.addTrace(traceState, successor));
+                ++search.statistics.generated;
+            });
+        }
+    }
+    setStatistics(search.statistics);
+    return solutions;
+}
+
+// The method enumerates the reachable states breadth first and records the valid successors of every state in the
+// order expand emits them, which is the order in which solveCost would push them.
+template<class StateTypeT, class CostTypeT>
+explicit_graph_t<StateTypeT> state_space_t<StateTypeT, CostTypeT>::buildGraph() const {
+    explicit_graph_t<StateTypeT> graph;
+    hash_visited_set_t<StateTypeT> numbers;
+    expansion_scratch_t<StateTypeT> expansion;
+    StateTypeT currentState{_startState};
+    auto noGoal = [](const StateTypeT &) { return false; };
+
+    numbers.insert(_startState);
+    graph.offsets.push_back(0);
+    for (std::size_t index = 0; index < numbers.size(); ++index) {
+        currentState = numbers.states()[index];
+        expand(_transitionFunctions, currentState, noGoal, expansion, [&](const StateTypeT &successor, bool) {
+            graph.targets.push_back(static_cast<std::uint32_t>(numbers.find_or_insert(successor).first));
+        });
+        graph.offsets.push_back(static_cast<std::uint32_t>(graph.targets.size()));
+    }
+    graph.states.assign(numbers.states().begin(), numbers.states().end());
+    return graph;
+}
+
+// The method expands the states in the order of their ranks, from a copy of the start state so that unrank only has to
+// restore what a rank describes.
+template<class StateTypeT, class CostTypeT>
+compiled_space_t<StateTypeT> state_space_t<StateTypeT, CostTypeT>::compile() const {
+    using rank_t = typename compiled_space_t<StateTypeT>::rank_t;
+    static_assert(state_rank<StateTypeT>::supported, "compile requires a state_rank specialization");
+    constexpr std::size_t count = state_rank<StateTypeT>::count;
+    std::vector<bool> valid(count);
+    std::vector<rank_t> offsets{0};
+    std::vector<rank_t> targets;
+    expansion_scratch_t<StateTypeT> expansion;
+    StateTypeT currentState{_startState};
+    auto noGoal = [](const StateTypeT &) { return false; };
+
+    for (std::size_t rank = 0; rank < count; ++rank) {
+        state_rank<StateTypeT>::unrank(rank, currentState);
+        valid[rank] = _invariantFunction(currentState);
+        expand(_transitionFunctions, currentState, noGoal, expansion, [&](const StateTypeT &successor, bool) {
+            targets.push_back(static_cast<rank_t>(state_rank<StateTypeT>::rank(successor)));
+        });
+        offsets.push_back(static_cast<rank_t>(targets.size()));
+    }
+    return compiled_space_t<StateTypeT>(std::move(valid), std::move(offsets), std::move(targets));
+}
+
+// Returns the cached graph, building it first if this is the first search that needs it. Searches that ask while it
+// is being built wait for it instead of building it again.
+template<class StateTypeT, class CostTypeT>
+std::shared_ptr<const explicit_graph_t<StateTypeT>> state_space_t<StateTypeT, CostTypeT>::graph() const {
+    std::lock_guard<std::mutex> lock(_graphMutex);
+    if (!_graph) {
+        _graph = std::make_shared<const explicit_graph_t<StateTypeT>>(buildGraph());
+    }
+    return _graph;
+}
+
+template<class StateTypeT, class CostTypeT>
+void state_space_t<StateTypeT, CostTypeT>::setStatistics(const search_statistics_t &statistics) const {
+    std::lock_guard<std::mutex> lock(_statisticsMutex);
+    _statistics = statistics;
+}
+
+// The method is solveCost over the cached graph, with state numbers in place of states. It takes states from waiting
+// in the same order as solveCost and so reports the same trace. Two kinds of pushes are left out, as solveCost would
+// skip them when taking them from waiting: successors that are passed already, and successors that are waiting with a
+// cost that is not higher, as that element is taken first. This is Dijkstra's algorithm with lazy deletion.
+template<class StateTypeT, class CostTypeT>
+template<class ValidationFunction>
+std::list<StateTypeT> state_space_t<StateTypeT, CostTypeT>::solveGraph(ValidationFunction isGoalState) const {
+    using node_t = trace_node<std::uint32_t>;
+    std::list<StateTypeT> solution;
+    search_statistics_t statistics;
+    const auto cached = graph();
+    const auto &graph = *cached;
+
+    auto scratch = scratch_pool_t<graph_search_state_t<open_list_for_t<CostTypeT, node_t *>, CostTypeT>>::acquire();
+    auto &traces = scratch->traces;
+    auto &waiting = scratch->waiting;
+    auto &passed = scratch->passed;
+    auto &reached = scratch->reached;
+    auto &best = scratch->best;
+    passed.assign(graph.size(), 0);
+    reached.assign(graph.size(), 0);
+    best.resize(graph.size());
+    const auto goals = graphGoals(graph, isGoalState);
+    auto isGoal = [&](std::uint32_t state) {
+        if constexpr (is_batch_predicate<StateTypeT, ValidationFunction>::value) {
+            return goals[state] != 0;
+        } else {
+            return isGoalState(graph.states[state]);
+        }
+    };
+
+    waiting.push(_initialCost, &traces.push_back(node_t{nullptr, 0}));
+    while (!waiting.empty()) {
+        auto element = waiting.pop();
+        const auto state = element.second->selfState;
+        if (isGoal(state)) {
+            for (auto *node = element.second; node != nullptr; node = node->parentState) {
+                solution.push_front(graph.states[node->selfState]);
+            }
+            break;
+        }
+        if (passed[state]) {
+            continue;
+        }
+        passed[state] = 1;
+        ++statistics.expanded;
+
+        for (auto index = graph.offsets[state]; index < graph.offsets[state + 1]; ++index) {
+            const auto successor = graph.targets[index];
+            if (passed[successor]) {
+                continue;
+            }
+            auto cost = _costFunction(graph.states[successor], element.first);
+            if (reached[successor] && !(cost < best[successor])) {
+                continue;
+            }
+            reached[successor] = 1;
+            best[successor] = cost;
+            waiting.push(cost, &traces.push_back(node_t{element.second, successor}));
+            ++statistics.generated;
+        }
+    }
+
+    setStatistics(statistics);
+    return solution;
+}
+
+// A batch goal is evaluated on all states of the graph at once, a state goal when its state is taken from waiting, so
+// for the latter the result is empty.
+template<class StateTypeT, class CostTypeT>
+template<class ValidationFunction>
+std::vector<std::uint8_t> state_space_t<StateTypeT, CostTypeT>::graphGoals(const explicit_graph_t<StateTypeT> &graph,
+                                                                           ValidationFunction &isGoalState) const {
+    std::vector<std::uint8_t> goals;
+    if constexpr (is_batch_predicate<StateTypeT, ValidationFunction>::value) {
+        goals.resize(graph.size());
+        soa_block_t<StateTypeT> block;
+        for (std::size_t first = 0; first < graph.size(); first += block.size) {
+            block.clear();
+            while (!block.full() && first + block.size < graph.size()) {
+                block.push(graph.states[first + block.size]);
+            }
+            auto mask = isGoalState(block);
+            for (std::size_t lane = 0; lane < block.size; ++lane) {
+                goals[first + lane] = (mask >> lane) & 1u;
+            }
+        }
+    }
+    return goals;
+}
+
+// The method is solveOrder over the cached graph, with state numbers in place of states. Every successor is pushed as
+// solveOrder pushes it, so the states are taken from waiting in the same order and the trace and the counters are the
+// same.
+template<class StateTypeT, class CostTypeT>
+template<class ValidationFunction>
+std::list<StateTypeT>
+state_space_t<StateTypeT, CostTypeT>::solveGraphOrder(ValidationFunction isGoalState, search_order_t order) const {
+    using node_t = trace_node<std::uint32_t>;
+    std::list<StateTypeT> solution;
+    search_statistics_t statistics;
+    const auto cached = graph();
+    const auto &graph = *cached;
+
+    auto scratch = scratch_pool_t<graph_search_state_t<waiting_list_t<node_t *>, std::nullptr_t>>::acquire();
+    auto &traces = scratch->traces;
+    auto &waiting = scratch->waiting;
+    auto &passed = scratch->passed;
+    const auto early = detectsWhenGenerated(order);
+    passed.assign(graph.size(), 0);
+    passed[0] = early;
+    const auto goals = graphGoals(graph, isGoalState);
+    auto isGoal = [&](std::uint32_t state) {
+        if constexpr (is_batch_predicate<StateTypeT, ValidationFunction>::value) {
+            return goals[state] != 0;
+        } else {
+            return isGoalState(graph.states[state]);
+        }
+    };
+
+    waiting.push_back(&traces.push_back(node_t{nullptr, 0}));
+    while (!waiting.empty()) {
+        node_t *node;
+        if (order == breadth_first) {
+            node = waiting.front();
+            waiting.pop_front();
+        } else {
+            node = waiting.back();
+            waiting.pop_back();
+        }
+        const auto state = node->selfState;
+        if (isGoal(state)) {
+            for (; node != nullptr; node = node->parentState) {
+                solution.push_front(graph.states[node->selfState]);
+            }
+            break;
+        }
+        if (!early) {
+            if (passed[state]) {
+                continue;
+            }
+            passed[state] = 1;
+        }
+        ++statistics.expanded;
+
+        for (auto index = graph.offsets[state]; index < graph.offsets[state + 1]; ++index) {
+            if (early) {
+                if (passed[graph.targets[index]]) {
+                    continue;
+                }
+                passed[graph.targets[index]] = 1;
+            }
+            waiting.push_back(&traces.push_back(node_t{node, graph.targets[index]}));
+            ++statistics.generated;
+        }
+    }
+
+    setStatistics(statistics);
     return solution;
 }
 
@@ -190,66 +1269,632 @@ std::list<StateTypeT> state_space_t<StateTypeT, CostTypeT>::solveCost(Validation
 template<class StateTypeT, class CostTypeT>
 template<class ValidationFunction>
 std::list<StateTypeT>
-state_space_t<StateTypeT, CostTypeT>::solveOrder(ValidationFunction isGoalState, search_order_t order) {
+state_space_t<StateTypeT, CostTypeT>::solveOrder(ValidationFunction isGoalState, search_order_t order) const {
+    if constexpr (has_column_unpack<StateTypeT>::value) {
+        if (_frontierLayout == column_arrays && _checkpoint.path.empty()) {
+            return solveColumns(isGoalState, order);
+        }
+    }
+    if (_isGraphCached && _checkpoint.path.empty() && (order == breadth_first || order == depth_first)) {
+        return solveGraphOrder(isGoalState, order);
+    }
+    if constexpr (state_serializer<StateTypeT>::supported) {
+        if (_chunkSize != 0 && order == breadth_first && _checkpoint.path.empty()) {
+            return solveChunked(isGoalState);
+        }
+    }
+    if constexpr (passed_set_t<StateTypeT>::collapsible) {
+        if (_visitedLayout == collapsed_states && _checkpoint.path.empty() &&
+            (order == breadth_first || order == depth_first)) {
+            return solveCollapsed<waiting_list_t<std::uint32_t>>(isGoalState, order, nullptr,
+                                                                 [](const StateTypeT &, std::nullptr_t) {
+                                                                     return nullptr;
+                                                                 });
+        }
+    }
+
     StateTypeT currentState;
     trace_node<StateTypeT> *traceState {};
-    std::list<StateTypeT> passed, solution;
-    std::list<trace_node<StateTypeT> *> waiting;
+    std::list<StateTypeT> solution;
+    auto scratch = scratch_pool_t<search_state_t<StateTypeT, trace_node<StateTypeT> *>>::acquire();
+    auto &search = *scratch;
+    auto &expansion = search.expansion;
+    auto &passed = search.passed;
+    auto &waiting = search.waiting;
+
+    // As solveOrder does not utilize a cost, waiting is just a list of trace_nodes. When duplicates are detected as
+    // states are generated, passed holds every state that was ever added to waiting.
+    const auto early = detectsWhenGenerated(order);
+    const auto kind = static_cast<std::uint8_t>(order | (early ? generatedDuplicatesKind : 0));
+    beginSearch(kind, search, static_cast<trace_node<StateTypeT> *>(nullptr));
+    if (early) {
+        passed.insert(_startState);
+    }
+    markBatchGoals(search, isGoalState);
 
-    // As solveOrder does not utilize a cost, waiting is just a list of trace_nodes.
-    waiting.push_back(new trace_node<StateTypeT>{nullptr, _startState});
+    // A breadth first search takes the states of a level from waiting before those of the next, so a level ends once
+    // all the states that were pushed before it began are taken.
+    trace_span_t level;
+    expansion_trace_t expansions;
+    std::size_t taken = 0, pushed = waiting.size(), levelEnd = 0, depth = 0;
 
     while (!waiting.empty()) {
-        switch (order) { // We switch on the order to determine what element should be accessed and popped from waiting.
-            case breadth_first:
-                currentState = waiting.front()->selfState;
-                traceState = waiting.front();
-                waiting.pop_front();
-                break;
-            case depth_first:
-                currentState = waiting.back()->selfState;
-                traceState = waiting.back();
-                waiting.pop_back();
-                break;
-            default:
-                std::cout << "Order not supported" << std::endl;
-                break;
+        if (order == breadth_first && taken++ == levelEnd) {
+            expansions.cut();
+            level.begin("search", "level", "depth", depth++);
+            levelEnd = pushed;
         }
-        if (isGoalState(currentState)) {
+        {
+            perf_phase_t phase(frontier_phase);
+            // We switch on the order to determine what element should be accessed and popped from waiting.
+            switch (order) {
+                case breadth_first:
+                    currentState = waiting.front()->selfState;
+                    traceState = waiting.front();
+                    waiting.pop_front();
+                    break;
+                case depth_first:
+                    currentState = waiting.back()->selfState;
+                    traceState = waiting.back();
+                    waiting.pop_back();
+                    break;
+                default:
+                    std::cout << "Order not supported" << std::endl;
+                    break;
+            }
+        }
+        if (reachedGoal(search, traceState, isGoalState)) {
             while (traceState->parentState != NULL) {
                 solution.push_front(traceState->selfState);
                 traceState = traceState->parentState;
             }
 
             solution.push_front(traceState->selfState); // Adds the start state to the solution trace.
+            endSearch(search);
             return solution;
         }
-        if (!(std::find(passed.begin(), passed.end(), currentState) != passed.end())) {
-            passed.push_back(currentState);
-            auto transitions = _transitionFunctions(currentState);
+        if (early || insertPassed(passed, currentState)) {
+            ++search.statistics.expanded;
+            expansions.expanded();
 
-            for (auto transition: transitions) {
-                auto successor{currentState};
-                transition(successor);
+            expand(_transitionFunctions, currentState, isGoalState, expansion,
+                   [&](const StateTypeT &successor, bool goal) {
+                if (early && !insertPassed(passed, successor)) {
+                    return;
+                }
+                perf_phase_t phase(frontier_phase);
+                auto *node = search.addTrace(traceState, successor);
+                if (goal) {
+                    search.batchGoals.insert(node);
+                }
+                waiting.push_back(node);
+                ++pushed;
+                ++search.statistics.generated;
+            });
+            checkpointIfDue(kind, search);
+        }
+    }
 
-                if (!_invariantFunction(successor)) { // Prevents invalid states being added to waiting.
-                    continue;
+    endSearch(search);
+    return solution;
+}
+
+// The method works like solveOrder, but keeps every generated state as a row of a soa_frontier_t. A breadth first search
+// takes the rows in order, so the waiting states are simply the rows after the current one and each level is
+// contiguous. A depth first search keeps a stack of row numbers, where the successors of one expansion are contiguous.
+// The parent row numbers replace the trace_nodes when rebuilding the trace.
+template<class StateTypeT, class CostTypeT>
+template<class ValidationFunction>
+std::list<StateTypeT>
+state_space_t<StateTypeT, CostTypeT>::solveColumns(ValidationFunction isGoalState, search_order_t order) const {
+    constexpr auto npos = soa_frontier_t<StateTypeT>::npos;
+    StateTypeT currentState{_startState};
+    std::list<StateTypeT> solution;
+    search_statistics_t statistics;
+    auto scratch = scratch_pool_t<column_search_state_t<StateTypeT>>::acquire();
+    auto &passed = scratch->passed;
+    auto &frontier = scratch->frontier;
+    auto &stack = scratch->stack; // the waiting rows of a depth first search
+    auto &expansion = scratch->expansion;
+    std::uint32_t next = 0;       // the next row of a breadth first search
+
+    if (order != breadth_first && order != depth_first) {
+        std::cout << "Order not supported" << std::endl;
+        return solution;
+    }
+    const auto early = detectsWhenGenerated(order);
+    passed.set_layout(_visitedLayout);
+    if (early) {
+        passed.insert(_startState);
+    }
+
+    frontier.push(_startState, npos);
+    if constexpr (is_batch_predicate<StateTypeT, ValidationFunction>::value) {
+        soa_block_t<StateTypeT> block;
+        block.push(_startState);
+        if (isGoalState(block) & 1u) {
+            frontier.mark_goal(0);
+        }
+    }
+    if (order == depth_first) {
+        stack.push_back(0);
+    }
+
+    // The rows of a breadth first level end where the rows of the level before ended when it was expanded.
+    trace_span_t level;
+    expansion_trace_t expansions;
+    std::uint32_t levelEnd = 0;
+    std::size_t depth = 0;
+
+    while (order == breadth_first ? next < frontier.size() : !stack.empty()) {
+        std::uint32_t index;
+        if (order == breadth_first) {
+            if (next == levelEnd) {
+                expansions.cut();
+                level.begin("search", "level", "depth", depth++);
+                levelEnd = static_cast<std::uint32_t>(frontier.size());
+            }
+            index = next++;
+        } else {
+            index = stack.back();
+            stack.pop_back();
+        }
+        frontier.load(index, currentState);
+
+        bool goal;
+        if constexpr (is_batch_predicate<StateTypeT, ValidationFunction>::value) {
+            goal = frontier.goal(index);
+        } else {
+            goal = isGoalState(currentState);
+        }
+        if (goal) {
+            for (; index != npos; index = frontier.parent(index)) {
+                frontier.load(index, currentState);
+                solution.push_front(currentState);
+            }
+            break;
+        }
+
+        if (early || passed.insert(currentState)) {
+            ++statistics.expanded;
+            expansions.expanded();
+            expand(_transitionFunctions, currentState, isGoalState, expansion,
+                   [&](const StateTypeT &successor, bool isGoal) {
+                if (early && !passed.insert(successor)) {
+                    return;
+                }
+                auto row = frontier.push(successor, index, isGoal);
+                if (order == depth_first) {
+                    stack.push_back(row);
                 }
-                waiting.push_back(new trace_node<StateTypeT>{traceState, successor});
+                ++statistics.generated;
+            });
+        }
+    }
+
+    setStatistics(statistics);
+    return solution;
+}
+
+// The method runs the search of solveOrder, or of solvePriority when WaitingListT is an open list, with the states kept
+// collapsed as described at collapsed_search_state_t. The states are taken from waiting in the same order as in those
+// searches, so the traces and the counters are the same. A state is interned when it is generated, which for the
+// searches that detect duplicates when generated is the test whether it was reached before. The others mark the
+// index of a state as passed when it is expanded, like solveOrder and solvePriority insert the state into passed.
+template<class StateTypeT, class CostTypeT>
+template<class WaitingListT, class ValidationFunction, class PriorityT, class PriorityFunction>
+std::list<StateTypeT>
+state_space_t<StateTypeT, CostTypeT>::solveCollapsed(ValidationFunction &isGoalState, search_order_t order,
+                                                     PriorityT initial, PriorityFunction priorityOf) const {
+    using search_t = collapsed_search_state_t<StateTypeT, WaitingListT>;
+    constexpr bool byPriority = !std::is_same<WaitingListT, waiting_list_t<std::uint32_t>>::value;
+    constexpr bool batchGoal = is_batch_predicate<StateTypeT, ValidationFunction>::value;
+    StateTypeT currentState{_startState};
+    std::list<StateTypeT> solution;
+    search_statistics_t statistics;
+    auto scratch = scratch_pool_t<search_t>::acquire();
+    auto &states = scratch->states;
+    auto &nodes = scratch->nodes;
+    auto &passed = scratch->passed;
+    auto &goals = scratch->goals;
+    auto &waiting = scratch->waiting;
+    auto &expansion = scratch->expansion;
+    const auto early = !byPriority && detectsWhenGenerated(order);
+    expansion_trace_t expansions;
+
+    // Returns the index of state and whether it is new. New states start out not passed.
+    auto intern = [&](const StateTypeT &state) {
+        perf_phase_t phase(visited_phase);
+        const auto interned = states.find_or_insert(state);
+        if (interned.second) {
+            passed.push_back(0);
+        }
+        return std::make_pair(static_cast<std::uint32_t>(interned.first), interned.second);
+    };
+    // Adds a trace node for the state with the given index, reached from the node parent, and puts it in waiting.
+    auto push = [&](std::uint32_t parent, std::uint32_t state, const PriorityT &priority, bool goal) {
+        perf_phase_t phase(frontier_phase);
+        nodes.push_back(typename search_t::node_t{parent, state});
+        const auto node = static_cast<std::uint32_t>(nodes.size() - 1);
+        if constexpr (batchGoal) {
+            goals.push_back(goal);
+        }
+        if constexpr (byPriority) {
+            waiting.push(priority, node);
+        } else {
+            waiting.push_back(node);
+        }
+    };
+
+    auto startGoal = false;
+    if constexpr (batchGoal) {
+        soa_block_t<StateTypeT> block;
+        block.push(_startState);
+        startGoal = (isGoalState(block) & 1u) != 0;
+    }
+    push(search_t::root, intern(_startState).first, initial, startGoal);
+
+    while (!waiting.empty()) {
+        std::uint32_t node;
+        PriorityT priority{initial};
+        {
+            perf_phase_t phase(frontier_phase);
+            if constexpr (byPriority) {
+                const auto element = waiting.pop();
+                priority = element.first;
+                node = element.second;
+            } else if (order == breadth_first) {
+                node = waiting.front();
+                waiting.pop_front();
+            } else {
+                node = waiting.back();
+                waiting.pop_back();
+            }
+        }
+        const auto state = nodes[node].state;
+        states.load(state, currentState);
+
+        bool goal;
+        if constexpr (batchGoal) {
+            goal = goals[node] != 0;
+        } else {
+            goal = isGoalState(currentState);
+        }
+        if (goal) {
+            for (auto index = node; index != search_t::root; index = nodes[index].parent) {
+                solution.push_front(states.state(nodes[index].state));
+            }
+            break;
+        }
+        if (!early) {
+            if (passed[state]) {
+                continue;
+            }
+            passed[state] = 1;
+        }
+        ++statistics.expanded;
+        expansions.expanded();
+
+        expand(_transitionFunctions, currentState, isGoalState, expansion,
+               [&](const StateTypeT &successor, bool isGoal) {
+            const auto interned = intern(successor);
+            if (early && !interned.second) {
+                return;
+            }
+            PriorityT successorPriority{initial};
+            if constexpr (byPriority) {
+                successorPriority = priorityOf(successor, priority);
+            }
+            push(node, interned.first, successorPriority, isGoal);
+            ++statistics.generated;
+        });
+    }
+
+    setStatistics(statistics);
+    return solution;
+}
+
+// The method is a breadth first search that works on chunks of waiting states. The trace store doubles as the waiting
+// list: it is filled in breadth first order, and the nodes after next are waiting. Each step of the expansion runs
+// over all successors of a chunk, so the calls to the transitions, the hash function and the invariant are made in
+// tight loops, and the visited set is probed for all successors after their slots have been prefetched.
+// States are checked against the goal as they are appended, in the same order in which solveOrder would take them
+// from waiting, so the search reports the same trace.
+template<class StateTypeT, class CostTypeT>
+template<class ValidationFunction>
+std::list<StateTypeT> state_space_t<StateTypeT, CostTypeT>::solveChunked(ValidationFunction isGoalState) const {
+    constexpr bool batchGoal = is_batch_predicate<StateTypeT, ValidationFunction>::value;
+    std::list<StateTypeT> solution;
+    search_statistics_t statistics;
+    auto scratch = scratch_pool_t<chunked_search_state_t<StateTypeT>>::acquire();
+    auto &traces = scratch->traces;
+    auto &visited = scratch->visited;
+    auto &successors = scratch->successors;
+    auto &parents = scratch->parents;
+    auto &hashes = scratch->hashes;
+    auto &keep = scratch->keep;
+
+    // Checks the nodes from first on against the goal and returns the first goal node, or nullptr.
+    auto findGoal = [&](std::size_t first) -> trace_node<StateTypeT> * {
+        if constexpr (batchGoal) {
+            auto &block = scratch->expansion.block;
+            for (auto index = first; index < traces.size(); index += block.size) {
+                block.clear();
+                while (!block.full() && index + block.size < traces.size()) {
+                    block.push(traces[index + block.size].selfState);
+                }
+                if (auto goals = isGoalState(block)) {
+                    return &traces[index + static_cast<std::size_t>(__builtin_ctzll(goals))];
+                }
+            }
+        } else {
+            for (auto index = first; index < traces.size(); ++index) {
+                if (isGoalState(traces[index].selfState)) {
+                    return &traces[index];
+                }
+            }
+        }
+        return nullptr;
+    };
+
+    // Clears keep for the kept successors that violate the invariant.
+    auto filterInvariant = [&]() {
+        if constexpr (state_columns<StateTypeT>::supported) {
+            if (_batchInvariant) {
+                auto &block = scratch->expansion.block;
+                std::array<std::size_t, soa_block_t<StateTypeT>::lanes> lanes;
+                block.clear();
+                auto flush = [&]() {
+                    auto valid = _batchInvariant(block);
+                    for (std::size_t lane = 0; lane < block.size; ++lane) {
+                        keep[lanes[lane]] = (valid >> lane) & 1u;
+                    }
+                    block.clear();
+                };
+                for (std::size_t i = 0; i < successors.size(); ++i) {
+                    if (keep[i]) {
+                        lanes[block.size] = i;
+                        block.push(successors[i]);
+                        if (block.full()) {
+                            flush();
+                        }
+                    }
+                }
+                if (block.size != 0) {
+                    flush();
+                }
+                return;
+            }
+        }
+        for (std::size_t i = 0; i < successors.size(); ++i) {
+            keep[i] = keep[i] && _invariantFunction(successors[i]);
+        }
+    };
+
+    traces.push_back(trace_node<StateTypeT>{nullptr, _startState});
+    visited.insert(_startState);
+    auto *goal = findGoal(0);
+    std::size_t next = 0;
+
+    while (goal == nullptr && next < traces.size()) {
+        const auto end = std::min(traces.size(), next + _chunkSize);
+        trace_span_t chunk("search", "chunk", "expanded", end - next);
+        successors.clear();
+        parents.clear();
+
+        // Generate the successors of the whole chunk.
+        for (; next < end; ++next) {
+            auto *node = &traces[next];
+            ++statistics.expanded;
+            for (auto &transition: _transitionFunctions(node->selfState)) {
+                successors.push_back(node->selfState);
+                transition(successors.back());
+                parents.push_back(node);
             }
         }
+
+        // Hash them all, then probe the visited set for all of them. New states are marked as visited right away,
+        // which also removes duplicates within the chunk.
+        hashes.resize(successors.size());
+        for (std::size_t i = 0; i < successors.size(); ++i) {
+            hashes[i] = visited.hash(successors[i]);
+        }
+        for (auto hash: hashes) {
+            visited.prefetch(hash);
+        }
+        keep.resize(successors.size());
+        for (std::size_t i = 0; i < successors.size(); ++i) {
+            keep[i] = visited.insert(successors[i], hashes[i]);
+        }
+
+        filterInvariant();
+
+        // Append the survivors to the waiting part of the trace store and check them against the goal.
+        const auto first = traces.size();
+        for (std::size_t i = 0; i < successors.size(); ++i) {
+            if (keep[i]) {
+                traces.push_back(trace_node<StateTypeT>{parents[i], std::move(successors[i])});
+            }
+        }
+        statistics.generated += traces.size() - first;
+        goal = findGoal(first);
     }
 
+    for (; goal != nullptr; goal = goal->parentState) {
+        solution.push_front(goal->selfState);
+    }
+    setStatistics(statistics);
     return solution;
 }
 
-// The following hash override is implemented in order to compile family.cpp. It is, however, never used and should
-// not be used at all. Gives a warning when compiling the program.
-template<class StateType, size_t typeSize>
-struct std::hash<std::array<StateType, typeSize>> {
-    std::size_t operator()(const array<StateType, typeSize> &key) const {
-        return NULL;
+// Generates the successors of state and hands the ones satisfying the invariant to emit(successor, goal), in the order
+// of the transitions. Without batch predicates every successor is checked by the invariant function on its own.
+// With a batch invariant, or a batch goal predicate as isGoalState, the successors are gathered into blocks and each
+// block is checked at once. goal is only ever true for a batch goal predicate, as single state goals are checked
+// when the state is taken from waiting.
+template<class StateTypeT, class CostTypeT>
+template<class GeneratorT, class ValidationFunction, class EmitT>
+void state_space_t<StateTypeT, CostTypeT>::expand(GeneratorT &generator, StateTypeT &state,
+                                                  ValidationFunction &isGoalState,
+                                                  expansion_scratch_t<StateTypeT> &scratch, EmitT emit) const {
+    perf_phase_t phase(successor_phase);
+    auto transitions = generator(state);
+    if constexpr (state_columns<StateTypeT>::supported) {
+        constexpr bool batchGoal = is_batch_predicate<StateTypeT, ValidationFunction>::value;
+        if (batchGoal || _batchInvariant) {
+            auto &block = scratch.block;
+            auto &successors = scratch.successors;
+
+            auto flush = [&]() {
+                std::uint64_t valid = 0, goals = 0;
+                {
+                    perf_phase_t invariantPhase(invariant_phase);
+                    if (_batchInvariant) {
+                        valid = _batchInvariant(block);
+                    } else {
+                        for (std::size_t lane = 0; lane < successors.size(); ++lane) {
+                            valid |= static_cast<std::uint64_t>(_invariantFunction(successors[lane])) << lane;
+                        }
+                    }
+                }
+                if constexpr (batchGoal) {
+                    goals = isGoalState(block);
+                }
+                for (std::size_t lane = 0; lane < successors.size(); ++lane) {
+                    if ((valid >> lane) & 1u) {
+                        emit(successors[lane], ((goals >> lane) & 1u) != 0);
+                    }
+                }
+                successors.clear();
+                block.clear();
+            };
+
+            for (auto &transition: transitions) {
+                successors.push_back(state);
+                transition(successors.back());
+                block.push(successors.back());
+                if (block.full()) {
+                    flush();
+                }
+            }
+            if (block.size != 0) {
+                flush();
+            }
+            return;
+        }
     }
-};
+
+    for (auto &transition: transitions) {
+        auto successor{state};
+        transition(successor);
+
+        bool valid;
+        {
+            perf_phase_t invariantPhase(invariant_phase);
+            valid = _invariantFunction(successor);
+        }
+        if (!valid) { // Prevents invalid states being added to waiting.
+            continue;
+        }
+        emit(successor, false);
+    }
+}
+
+// Evaluates a batch goal predicate on the states in waiting when a search begins, which are the start state or the
+// states restored from a checkpoint. Does nothing for single state goal predicates.
+template<class StateTypeT, class CostTypeT>
+template<class SearchT, class ValidationFunction>
+void state_space_t<StateTypeT, CostTypeT>::markBatchGoals(SearchT &search, ValidationFunction &isGoalState) const {
+    if constexpr (is_batch_predicate<StateTypeT, ValidationFunction>::value) {
+        soa_block_t<StateTypeT> block;
+        std::array<const trace_node<StateTypeT> *, soa_block_t<StateTypeT>::lanes> nodes{}; // the node of each lane
+        auto flush = [&]() {
+            auto goals = isGoalState(block);
+            for (std::size_t lane = 0; lane < block.size; ++lane) {
+                if ((goals >> lane) & 1u) {
+                    search.batchGoals.insert(nodes[lane]);
+                }
+            }
+            block.clear();
+        };
+        for_each_waiting(search.waiting, [&](const typename SearchT::waiting_element_t &element) {
+            nodes[block.size] = waiting_node(element);
+            block.push(nodes[block.size]->selfState);
+            if (block.full()) {
+                flush();
+            }
+        });
+        if (block.size != 0) {
+            flush();
+        }
+    }
+}
+
+// Tells whether the state of traceState, which was just taken from waiting, is a goal.
+template<class StateTypeT, class CostTypeT>
+template<class SearchT, class ValidationFunction>
+bool state_space_t<StateTypeT, CostTypeT>::reachedGoal(SearchT &search, const trace_node<StateTypeT> *traceState,
+                                                       ValidationFunction &isGoalState) const {
+    if constexpr (is_batch_predicate<StateTypeT, ValidationFunction>::value) {
+        return search.batchGoals.count(traceState) != 0;
+    } else {
+        return isGoalState(traceState->selfState);
+    }
+}
+
+// Prepares a search by continuing from the checkpoint file if one is enabled and present. Otherwise the waiting list
+// is initialized with startElement pointing to a new trace_node for the start state.
+template<class StateTypeT, class CostTypeT>
+template<class SearchT>
+void state_space_t<StateTypeT, CostTypeT>::beginSearch(std::uint8_t kind, SearchT &search,
+                                                       const typename SearchT::waiting_element_t &startElement) const {
+    using waiting_t = typename SearchT::waiting_element_t;
+    search.passed.set_layout(_visitedLayout);
+    if constexpr (is_checkpointable_v<StateTypeT, waiting_t>) {
+        if (!_checkpoint.path.empty() && load_checkpoint(_checkpoint.path, kind, _startState, search)) {
+            return;
+        }
+    } else if (!_checkpoint.path.empty()) {
+        std::cerr << "Checkpoints are not supported for this state or cost type" << std::endl;
+    }
+
+    auto *startNode = search.addTrace(nullptr, _startState);
+    if constexpr (std::is_pointer<waiting_t>::value) {
+        push_waiting(search.waiting, startNode);
+    } else {
+        push_waiting(search.waiting, waiting_t{startElement.first, startNode});
+    }
+}
+
+// Called after each expansion. Saves the search if the expansion interval is reached or a checkpoint was requested.
+template<class StateTypeT, class CostTypeT>
+template<class SearchT>
+void state_space_t<StateTypeT, CostTypeT>::checkpointIfDue(std::uint8_t kind, SearchT &search) const {
+    if constexpr (is_checkpointable_v<StateTypeT, typename SearchT::waiting_element_t>) {
+        if (_checkpoint.path.empty()) {
+            return;
+        }
+        if (!checkpoint_requested &&
+            (_checkpoint.interval == 0 || search.statistics.expanded % _checkpoint.interval != 0)) {
+            return;
+        }
+        checkpoint_requested = 0;
+        ++search.statistics.checkpoints;
+        if (!save_checkpoint(_checkpoint.path, kind, _startState, search)) {
+            std::cerr << "Could not write checkpoint " << _checkpoint.path << std::endl;
+        }
+    }
+}
+
+// Called when a search finishes, either with a solution or because the waiting list ran empty. A finished search has
+// nothing left to continue, so its checkpoint is removed.
+template<class StateTypeT, class CostTypeT>
+template<class SearchT>
+void state_space_t<StateTypeT, CostTypeT>::endSearch(SearchT &search) const {
+    if (!_checkpoint.path.empty()) {
+        std::remove(_checkpoint.path.c_str());
+    }
+    setStatistics(search.statistics);
+}
 
 #endif //PUZZLEENGINE_REACHABILITY_HPP
\ No newline at end of file
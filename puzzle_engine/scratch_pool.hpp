@@ -0,0 +1,90 @@
+/**
+ * Reusable working memory for searches. A search takes its working data from scratch_pool_t instead of building it
+ * from scratch, and hands it back cleared but with its memory when it ends, so the next search on the same thread
+ * starts with the tables, lists and trace nodes grown by the searches before it. Every thread has pools of its own,
+ * so concurrent searches never share scratch, and a search that starts another search while it runs (e.g. from a
+ * goal predicate) simply takes a second object from the pool.
+ */
+
+#ifndef PUZZLEENGINE_SCRATCH_POOL_HPP
+#define PUZZLEENGINE_SCRATCH_POOL_HPP
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+// The trim functions of the pools the calling thread has used.
+inline std::vector<void (*)()> &scratch_pool_trims() {
+    thread_local std::vector<void (*)()> trims;
+    return trims;
+}
+
+// Releases the objects in every pool of the calling thread. Threads that serve many searches call it when a batch of
+// them ends, so that a thread does not hold the memory of its largest search for good.
+inline void trim_scratch_pools() {
+    for (auto trim: scratch_pool_trims()) {
+        trim();
+    }
+}
+
+// The pool of objects of type T of the calling thread. T must be default constructible and have a clear() that
+// empties the object but keeps its memory.
+template<class T>
+class scratch_pool_t {
+public:
+    // An object taken from the pool, which goes back to the pool when the lease ends.
+    class lease_t {
+    public:
+        explicit lease_t(std::unique_ptr<T> object) : _object(std::move(object)) {
+        }
+
+        lease_t(const lease_t &) = delete;
+
+        lease_t &operator=(const lease_t &) = delete;
+
+        ~lease_t() {
+            _object->clear();
+            objects().push_back(std::move(_object));
+        }
+
+        T &operator*() const {
+            return *_object;
+        }
+
+        T *operator->() const {
+            return _object.get();
+        }
+
+    private:
+        std::unique_ptr<T> _object;
+    };
+
+    // Takes an object from the pool of the calling thread, or a new one if the pool is empty.
+    static lease_t acquire() {
+        auto &pool = objects();
+        if (pool.empty()) {
+            return lease_t(std::make_unique<T>());
+        }
+        auto object = std::move(pool.back());
+        pool.pop_back();
+        return lease_t(std::move(object));
+    }
+
+    // Releases the objects in the pool of the calling thread, e.g. after an unusually large search.
+    static void trim() {
+        objects().clear();
+    }
+
+private:
+    static std::vector<std::unique_ptr<T>> &objects() {
+        thread_local std::vector<std::unique_ptr<T>> pool;
+        thread_local bool registered = false;
+        if (!registered) {
+            scratch_pool_trims().push_back(&trim);
+            registered = true;
+        }
+        return pool;
+    }
+};
+
+#endif //PUZZLEENGINE_SCRATCH_POOL_HPP
@@ -0,0 +1,411 @@
+/**
+ * The working data of a single search in the reachability library: the trace store, the passed and waiting lists
+ * and the counters. Keeping it in one place allows a search to be saved to a file and continued later, and lets
+ * searches take it from a scratch_pool_t: every structure here can be cleared without giving up its memory.
+ */
+
+#ifndef PUZZLEENGINE_SEARCH_STATE_HPP
+#define PUZZLEENGINE_SEARCH_STATE_HPP
+
+#include "collapse.hpp"
+#include "frontier.hpp"
+#include "visited_set.hpp"
+#include "memory_accounting.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// This struct is the basis for keeping track of the solution when traversing the states. When it is used, it holds a
+// pointer to the parent node as well as a copy of the state.
+template<class StateTypeT>
+struct trace_node {
+    trace_node *parentState;
+    StateTypeT selfState;
+};
+
+// The buffers in which expand() gathers the successors of a state when batch predicates are used: the successors and
+// the block of their columns. A search keeps them for all its expansions, so they are neither allocated nor cleared
+// per expansion. States without columns have no batch predicates and need no buffers.
+template<class StateTypeT, bool = state_columns<StateTypeT>::supported>
+struct expansion_scratch_t {
+    accounted_vector_t<StateTypeT, waiting_memory> successors;
+    soa_block_t<StateTypeT> block;
+
+    void clear() {
+        successors.clear();
+        block.clear();
+    }
+};
+
+template<class StateTypeT>
+struct expansion_scratch_t<StateTypeT, false> {
+    void clear() {
+    }
+};
+
+// The counters collected while searching. A search that is continued from a checkpoint keeps counting from the
+// values that were saved.
+struct search_statistics_t {
+    std::size_t expanded{0};    // states taken from waiting that were not passed before
+    std::size_t generated{0};   // successors that satisfied the invariant and were added to waiting
+    std::size_t checkpoints{0}; // number of times the search has been saved to a file
+};
+
+// The store of the trace_nodes of a search. The nodes live in blocks that never move, so pointers to them stay valid
+// while the store grows. Clearing keeps the blocks and the nodes in them, and new nodes are assigned over the old
+// ones, so a reused store allocates neither blocks nor, for states like vectors, the memory of the states. The memory
+// the states in the slots own is accounted as it changes.
+template<class NodeT>
+class trace_arena_t {
+public:
+    NodeT &push_back(const NodeT &node) {
+        auto &slot = nextSlot();
+        const auto before = heapBytes(slot);
+        slot = node;
+        _stateBytes.add(static_cast<std::int64_t>(heapBytes(slot)) - static_cast<std::int64_t>(before));
+        return slot;
+    }
+
+    NodeT &push_back(NodeT &&node) {
+        auto &slot = nextSlot();
+        const auto before = heapBytes(slot);
+        slot = std::move(node);
+        _stateBytes.add(static_cast<std::int64_t>(heapBytes(slot)) - static_cast<std::int64_t>(before));
+        return slot;
+    }
+
+    NodeT &back() {
+        return (*this)[_size - 1];
+    }
+
+    NodeT &operator[](std::size_t index) {
+        return _blocks[index / blockSize][index % blockSize];
+    }
+
+    const NodeT &operator[](std::size_t index) const {
+        return _blocks[index / blockSize][index % blockSize];
+    }
+
+    std::size_t size() const {
+        return _size;
+    }
+
+    bool empty() const {
+        return _size == 0;
+    }
+
+    void clear() {
+        _size = 0;
+    }
+
+private:
+    using block_t = accounted_vector_t<NodeT, trace_memory>;
+    static constexpr std::size_t blockSize = 1024;
+    accounted_vector_t<block_t, trace_memory> _blocks; // moving a block keeps its nodes in place
+    std::size_t _size{0};
+    accounted_bytes_t<state_memory> _stateBytes;
+
+    static std::size_t heapBytes(const NodeT &node) {
+        return state_heap_bytes<std::decay_t<decltype(node.selfState)>>::of(node.selfState);
+    }
+
+    NodeT &nextSlot() {
+        if (_size == _blocks.size() * blockSize) {
+            _blocks.emplace_back(blockSize);
+        }
+        return (*this)[_size++];
+    }
+};
+
+// The waiting list of breadth and depth first searches: a vector taken from the front as a queue or from the back as
+// a stack. Taking from the front only advances an index, and the taken elements are dropped once they are at least
+// half of the vector, so the list stays within twice its size and its memory is kept between searches.
+template<class T>
+class waiting_list_t {
+public:
+    void push_back(const T &element) {
+        _elements.push_back(element);
+    }
+
+    T &front() {
+        return _elements[_head];
+    }
+
+    T &back() {
+        return _elements.back();
+    }
+
+    void pop_front() {
+        if (++_head == _elements.size()) {
+            clear();
+        } else if (_head >= 1024 && _head * 2 >= _elements.size()) {
+            _elements.erase(_elements.begin(), _elements.begin() + static_cast<std::ptrdiff_t>(_head));
+            _head = 0;
+        }
+    }
+
+    void pop_back() {
+        _elements.pop_back();
+        if (_head == _elements.size()) {
+            clear();
+        }
+    }
+
+    bool empty() const {
+        return _head == _elements.size();
+    }
+
+    std::size_t size() const {
+        return _elements.size() - _head;
+    }
+
+    void clear() {
+        _elements.clear();
+        _head = 0;
+    }
+
+    // Calls fn with every element from the front to the back.
+    template<class FunctionT>
+    void for_each(FunctionT fn) const {
+        for (auto index = _head; index < _elements.size(); ++index) {
+            fn(_elements[index]);
+        }
+    }
+
+private:
+    accounted_vector_t<T, waiting_memory> _elements;
+    std::size_t _head{0}; // the elements before it have been taken
+};
+
+// Selects how the passed states of a search are stored: as full copies in a hash set, or collapsed into tuples of
+// interned parts by collapse_visited_set_t, which needs far less memory for states with repeating parts.
+enum visited_layout_t {
+    full_states, collapsed_states
+};
+
+// The passed states of a search. The layout can only be changed while the set is empty. States that cannot be
+// collapsed are always stored in full.
+template<class StateTypeT>
+class passed_set_t {
+public:
+    static constexpr bool collapsible = collapse_layout<StateTypeT>::supported && is_bitwise_state_v<StateTypeT>;
+
+    void set_layout(visited_layout_t layout) {
+        _layout = collapsible ? layout : full_states;
+    }
+
+    visited_layout_t layout() const {
+        return _layout;
+    }
+
+    // Adds state unless it was passed before. Returns whether it was added.
+    bool insert(const StateTypeT &state) {
+        if constexpr (collapsible) {
+            if (_layout == collapsed_states) {
+                return _collapsed.insert(state);
+            }
+        }
+        return _states.insert(state);
+    }
+
+    std::size_t size() const {
+        if constexpr (collapsible) {
+            if (_layout == collapsed_states) {
+                return _collapsed.size();
+            }
+        }
+        return _states.size();
+    }
+
+    // Calls fn with every passed state in the order they were passed.
+    template<class FunctionT>
+    void for_each(FunctionT fn) const {
+        if constexpr (collapsible) {
+            if (_layout == collapsed_states) {
+                _collapsed.for_each(fn);
+                return;
+            }
+        }
+        _states.for_each(fn);
+    }
+
+    // The bytes held by the set.
+    std::size_t memory() const {
+        if constexpr (collapsible) {
+            if (_layout == collapsed_states) {
+                return _collapsed.memory();
+            }
+        }
+        return _states.memory();
+    }
+
+    // Empties the set but keeps its memory. The layout can be changed again afterwards.
+    void clear() {
+        _states.clear();
+        if constexpr (collapsible) {
+            _collapsed.clear();
+        }
+    }
+
+private:
+    visited_layout_t _layout{full_states};
+    hash_visited_set_t<StateTypeT> _states;
+    std::conditional_t<collapsible, collapse_visited_set_t<StateTypeT>, std::nullptr_t> _collapsed{};
+};
+
+// This struct holds everything a search works on. The trace store owns all trace_nodes created during the search,
+// so they are released together with the search. WaitingT is the element type of the waiting list, which is a
+// trace_node pointer for ordered searches and a pair of cost and trace_node pointer for cost searches. The waiting
+// list of a cost search is one of the open lists of open_list.hpp.
+template<class StateTypeT, class WaitingT, class WaitingListT = waiting_list_t<WaitingT>>
+struct search_state_t {
+    using waiting_element_t = WaitingT;
+
+    trace_arena_t<trace_node<StateTypeT>> traces;
+    passed_set_t<StateTypeT> passed;
+    WaitingListT waiting;
+    search_statistics_t statistics;
+    expansion_scratch_t<StateTypeT> expansion;
+    // The trace_nodes whose states satisfy a batch goal predicate. Batch goals are evaluated when the states are
+    // generated, and this set carries the answer to the point where the state is taken from waiting.
+    std::unordered_set<const trace_node<StateTypeT> *, std::hash<const trace_node<StateTypeT> *>,
+                       std::equal_to<const trace_node<StateTypeT> *>,
+                       accounting_allocator_t<const trace_node<StateTypeT> *, waiting_memory>> batchGoals;
+
+    trace_node<StateTypeT> *addTrace(trace_node<StateTypeT> *parent, const StateTypeT &state) {
+        return &traces.push_back(trace_node<StateTypeT>{parent, state});
+    }
+
+    void clear() {
+        traces.clear();
+        passed.clear();
+        waiting.clear();
+        statistics = search_statistics_t{};
+        expansion.clear();
+        batchGoals.clear();
+    }
+};
+
+// The working data of a search over an explicit_graph_t, where states are known by their numbers: the trace store,
+// the waiting list, a flag per state for passed and for reached and the best cost a state was reached with. The
+// flags are sized to the graph when a search begins.
+template<class WaitingListT, class CostTypeT>
+struct graph_search_state_t {
+    trace_arena_t<trace_node<std::uint32_t>> traces;
+    WaitingListT waiting;
+    accounted_vector_t<std::uint8_t, passed_memory> passed, reached;
+    accounted_vector_t<CostTypeT, waiting_memory> best;
+
+    void clear() {
+        traces.clear();
+        waiting.clear();
+        passed.clear();
+        reached.clear();
+        best.clear();
+    }
+};
+
+// The working data of a search over a soa_frontier_t: the frontier, the passed states and the waiting rows of a depth
+// first search.
+template<class StateTypeT>
+struct column_search_state_t {
+    soa_frontier_t<StateTypeT> frontier;
+    passed_set_t<StateTypeT> passed;
+    accounted_vector_t<std::uint32_t, waiting_memory> stack;
+    expansion_scratch_t<StateTypeT> expansion;
+
+    void clear() {
+        frontier.clear();
+        passed.clear();
+        stack.clear();
+        expansion.clear();
+    }
+};
+
+// The working data of a search that keeps its states collapsed. Every generated state is interned once in states and
+// known by its index there, and a trace node holds the index of its state and of its parent node, so each generated
+// state costs the indices of its parts once plus eight bytes per trace node. passed holds a flag per state index, and
+// goals a flag per node for the states that satisfy a batch goal predicate.
+template<class StateTypeT, class WaitingListT>
+struct collapsed_search_state_t {
+    struct node_t {
+        std::uint32_t parent;
+        std::uint32_t state;
+    };
+
+    static constexpr std::uint32_t root = UINT32_MAX; // the parent of the node of the start state
+
+    collapse_visited_set_t<StateTypeT> states;
+    accounted_vector_t<node_t, trace_memory> nodes;
+    accounted_vector_t<std::uint8_t, passed_memory> passed;
+    accounted_vector_t<std::uint8_t, waiting_memory> goals;
+    WaitingListT waiting;
+    expansion_scratch_t<StateTypeT> expansion;
+
+    void clear() {
+        states.clear();
+        nodes.clear();
+        passed.clear();
+        goals.clear();
+        waiting.clear();
+        expansion.clear();
+    }
+};
+
+// The working data of a chunked breadth first search: the trace store, which is also its waiting list, the visited
+// states and the successors of the current chunk with their parents, hashes and whether they are kept.
+template<class StateTypeT>
+struct chunked_search_state_t {
+    trace_arena_t<trace_node<StateTypeT>> traces;
+    hash_visited_set_t<StateTypeT> visited;
+    accounted_vector_t<StateTypeT, waiting_memory> successors;
+    accounted_vector_t<trace_node<StateTypeT> *, waiting_memory> parents;
+    accounted_vector_t<std::size_t, waiting_memory> hashes;
+    accounted_vector_t<std::uint8_t, waiting_memory> keep;
+    expansion_scratch_t<StateTypeT> expansion; // only its block is used, for the batch predicates
+
+    void clear() {
+        traces.clear();
+        visited.clear();
+        successors.clear();
+        parents.clear();
+        hashes.clear();
+        keep.clear();
+        expansion.clear();
+    }
+};
+
+// Calls fn with every element of a waiting list. Plain lists are visited front to back, open lists in push order.
+template<class OpenListT, class FunctionT>
+void for_each_waiting(const OpenListT &waiting, FunctionT fn) {
+    waiting.for_each(fn);
+}
+
+// Returns the trace_node of a waiting list element.
+template<class StateTypeT>
+trace_node<StateTypeT> *waiting_node(trace_node<StateTypeT> *element) {
+    return element;
+}
+
+template<class CostTypeT, class StateTypeT>
+trace_node<StateTypeT> *waiting_node(const std::pair<CostTypeT, trace_node<StateTypeT> *> &element) {
+    return element.second;
+}
+
+// Adds an element to the back of a plain waiting list or pushes the pair of cost and value onto an open list.
+template<class WaitingT>
+void push_waiting(waiting_list_t<WaitingT> &waiting, const WaitingT &element) {
+    waiting.push_back(element);
+}
+
+template<class OpenListT, class CostTypeT, class ValueT>
+void push_waiting(OpenListT &waiting, const std::pair<CostTypeT, ValueT> &element) {
+    waiting.push(element.first, element.second);
+}
+
+#endif //PUZZLEENGINE_SEARCH_STATE_HPP
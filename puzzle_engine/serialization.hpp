@@ -0,0 +1,142 @@
+/**
+ * Binary serialization of states and costs used by the reachability library.
+ * The state_serializer trait writes a value to a binary stream and reads it back. Trivially copyable types are
+ * written as raw bytes, std::vector and std::array are written element by element. Other types can be supported by
+ * specializing state_serializer with a supported flag and a write/read pair.
+ */
+
+#ifndef PUZZLEENGINE_SERIALIZATION_HPP
+#define PUZZLEENGINE_SERIALIZATION_HPP
+
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <streambuf>
+#include <type_traits>
+
+// The primary template is used for types that cannot be serialized. The supported flag lets the library check at
+// compile time whether a state type can be written to a file, so that the library only fails when serialization is
+// actually requested.
+template<class T, class Enable = void>
+struct state_serializer {
+    static constexpr bool supported = false;
+};
+
+// Trivially copyable types (enums, plain structs, arrays of these) are written as their raw object representation.
+template<class T>
+struct state_serializer<T, std::enable_if_t<std::is_trivially_copyable<T>::value>> {
+    static constexpr bool supported = true;
+
+    static void write(std::ostream &out, const T &value) {
+        out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    static bool read(std::istream &in, T &value) {
+        return static_cast<bool>(in.read(reinterpret_cast<char *>(&value), sizeof(T)));
+    }
+};
+
+// Vectors are written as their size followed by each of the elements.
+template<class T, class AllocatorT>
+struct state_serializer<std::vector<T, AllocatorT>> {
+    static constexpr bool supported = state_serializer<T>::supported;
+
+    static void write(std::ostream &out, const std::vector<T, AllocatorT> &value) {
+        state_serializer<std::uint64_t>::write(out, value.size());
+        for (auto &element: value) {
+            state_serializer<T>::write(out, element);
+        }
+    }
+
+    static bool read(std::istream &in, std::vector<T, AllocatorT> &value) {
+        std::uint64_t size{};
+        if (!state_serializer<std::uint64_t>::read(in, size)) {
+            return false;
+        }
+        // The elements are appended one by one, so a corrupt size makes the read fail at the end of the input instead of
+        // allocating that many elements up front.
+        value.clear();
+        value.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(size, 4096)));
+        for (std::uint64_t index = 0; index < size; ++index) {
+            T element{};
+            if (!state_serializer<T>::read(in, element)) {
+                return false;
+            }
+            value.push_back(element);
+        }
+        return true;
+    }
+};
+
+// Arrays of trivially copyable elements are handled by the raw specialization above, the rest are written element by
+// element.
+template<class T, std::size_t size>
+struct state_serializer<std::array<T, size>, std::enable_if_t<!std::is_trivially_copyable<std::array<T, size>>::value>> {
+    static constexpr bool supported = state_serializer<T>::supported;
+
+    static void write(std::ostream &out, const std::array<T, size> &value) {
+        for (auto &element: value) {
+            state_serializer<T>::write(out, element);
+        }
+    }
+
+    static bool read(std::istream &in, std::array<T, size> &value) {
+        for (auto &element: value) {
+            if (!state_serializer<T>::read(in, element)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Writes the serialized form of value into bytes, replacing its contents. The result can be used as a fixed width key
+// for states whose serialized size does not vary, like all states of one puzzle instance.
+template<class T>
+void pack_state(const T &value, std::string &bytes) {
+    // A stream buffer that appends to bytes, so a string that is reused for every state keeps its capacity and packing
+    // does not allocate once it has grown to the size of a state.
+    struct string_buffer_t : std::streambuf {
+        explicit string_buffer_t(std::string &target) : target(target) {
+        }
+
+        int_type overflow(int_type ch) override {
+            if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+                target.push_back(traits_type::to_char_type(ch));
+            }
+            return traits_type::not_eof(ch);
+        }
+
+        std::streamsize xsputn(const char *chars, std::streamsize count) override {
+            target.append(chars, static_cast<std::size_t>(count));
+            return count;
+        }
+
+        std::string &target;
+    };
+    bytes.clear();
+    string_buffer_t buffer(bytes);
+    std::ostream out(&buffer);
+    state_serializer<T>::write(out, value);
+}
+
+// Reads value back from bytes written by pack_state. Returns false if the bytes do not hold a complete value.
+template<class T>
+bool unpack_state(const char *bytes, std::size_t size, T &value) {
+    // A read-only stream buffer over the bytes, so they do not have to be copied into a string first.
+    struct memory_buffer_t : std::streambuf {
+        memory_buffer_t(const char *begin, std::size_t length) {
+            auto *first = const_cast<char *>(begin);
+            setg(first, first, first + length);
+        }
+    };
+    memory_buffer_t buffer(bytes, size);
+    std::istream in(&buffer);
+    return state_serializer<T>::read(in, value);
+}
+
+#endif //PUZZLEENGINE_SERIALIZATION_HPP
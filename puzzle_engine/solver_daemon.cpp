@@ -0,0 +1,275 @@
+/**
+ * A long running solver for the bundled puzzles, serving requests over a Unix domain socket with the protocol of
+ * solver_protocol.hpp. The daemon keeps a session per puzzle and start state, which holds:
+ * - a state space with its graph cache enabled, so the reachable states and their successors are explored by the
+ *   first request and every later search from that start state runs over the cached graph,
+ * - the answers to earlier requests, so a repeated request is answered without searching at all.
+ * Every connection is served by a thread of its own, up to max_connections at once, and sessions are locked one at a
+ * time, so requests for different start states are solved in parallel. The thread of a connection keeps the scratch
+ * memory of its searches for the next request and releases it when the connection is closed and the thread ends.
+ * Compile and run:
+ * g++ -std=c++17 -pedantic -Wall -DNDEBUG -O3 -pthread -o solver_daemon solver_daemon.cpp && ./solver_daemon [socket]
+ */
+#include "frogs.hpp"
+#include "crossing.hpp"
+#include "family.hpp"
+#include "solver_protocol.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Limits on what the daemon keeps. A table that is full is emptied before the next entry is added.
+constexpr std::size_t max_sessions = 256;
+constexpr std::size_t max_answers = 4096;
+// The connections served at once. Further clients wait in the listen backlog until a connection is closed.
+constexpr std::size_t max_connections = 64;
+
+// Answers the requests for one puzzle.
+template<class StateTypeT, class CostTypeT = std::nullptr_t>
+class puzzle_service_t {
+public:
+	using space_t = state_space_t<StateTypeT, CostTypeT>;
+
+	// makeSpace creates the state space of a start state, accepts tells whether a state may be sent by clients, and
+	// isGoal(start, state) is the goal of the puzzle for a start state.
+	puzzle_service_t(std::function<space_t(const StateTypeT&)> makeSpace,
+					 std::function<bool(const StateTypeT&)> accepts,
+					 std::function<bool(const StateTypeT&, const StateTypeT&)> isGoal):
+		_makeSpace(std::move(makeSpace)), _accepts(std::move(accepts)), _isGoal(std::move(isGoal)) {}
+
+	// Returns the response to a request, including the trace.
+	std::string answer(std::uint8_t order, const std::string& startKey, const std::string& targetKey) {
+		auto start = StateTypeT{}, target = StateTypeT{};
+		if (order > search_order_t::depth_first || !decode(startKey, start) ||
+			(!targetKey.empty() && !decode(targetKey, target)))
+			return encode(solver_bad_request, {}, {});
+
+		auto session = find_session(startKey, start);
+		auto lock = std::lock_guard<std::mutex>{session->mutex};
+		auto key = std::string(1, static_cast<char>(order)) + targetKey;
+		auto known = session->answers.find(key);
+		if (known != session->answers.end()) {
+			auto response = known->second;
+			response[offsetof(solver_response_t, cached)] = 1;
+			return response;
+		}
+
+		auto trace = targetKey.empty()
+			? session->space.check([&](const StateTypeT& state){ return _isGoal(start, state); },
+								   static_cast<search_order_t>(order))
+			: session->space.check([&](const StateTypeT& state){ return state_equal<StateTypeT>{}(state, target); },
+								   static_cast<search_order_t>(order));
+		auto response = encode(trace.empty() ? solver_unreachable : solver_solved, trace,
+							   session->space.statistics());
+		if (session->answers.size() >= max_answers)
+			session->answers.clear();
+		session->answers.emplace(std::move(key), response);
+		return response;
+	}
+
+private:
+	struct session_t {
+		explicit session_t(space_t space): space(std::move(space)) {}
+		std::mutex mutex;
+		space_t space;
+		std::unordered_map<std::string, std::string> answers; // by order and packed target
+	};
+
+	std::function<space_t(const StateTypeT&)> _makeSpace;
+	std::function<bool(const StateTypeT&)> _accepts;
+	std::function<bool(const StateTypeT&, const StateTypeT&)> _isGoal;
+	std::mutex _mutex;
+	std::unordered_map<std::string, std::shared_ptr<session_t>> _sessions; // by packed start state
+
+	// Only states that pack back to the same bytes are accepted, so that equal states always share one session.
+	bool decode(const std::string& key, StateTypeT& state) const {
+		auto packed = std::string{};
+		if (!unpack_state(key.data(), key.size(), state))
+			return false;
+		pack_state(state, packed);
+		return packed == key && _accepts(state);
+	}
+
+	std::shared_ptr<session_t> find_session(const std::string& startKey, const StateTypeT& start) {
+		auto lock = std::lock_guard<std::mutex>{_mutex};
+		auto found = _sessions.find(startKey);
+		if (found != _sessions.end())
+			return found->second;
+		if (_sessions.size() >= max_sessions)
+			_sessions.clear();
+		auto space = _makeSpace(start);
+		space.enable_graph_cache();
+		return _sessions[startKey] = std::make_shared<session_t>(std::move(space));
+	}
+
+	static std::string encode(solver_status_t status, const std::list<StateTypeT>& trace,
+							  const search_statistics_t& statistics) {
+		auto header = solver_response_t{};
+		std::memcpy(header.magic, solver_response_magic, sizeof(header.magic));
+		header.status = status;
+		header.stateCount = static_cast<std::uint32_t>(trace.size());
+		header.expanded = statistics.expanded;
+		header.generated = statistics.generated;
+		auto response = std::string(sizeof(header), '\0');
+		auto key = std::string{};
+		for (auto&& state: trace) {
+			pack_state(state, key);
+			auto size = static_cast<std::uint32_t>(key.size());
+			response.append(reinterpret_cast<const char*>(&size), sizeof(size));
+			response.append(key);
+		}
+		header.traceSize = static_cast<std::uint32_t>(response.size() - sizeof(header));
+		std::memcpy(&response[0], &header, sizeof(header));
+		return response;
+	}
+};
+
+// Frog puzzles of up to eight frogs of each colour, solved by swapping the frogs.
+puzzle_service_t<stones_t> frogs_service{
+	[](const stones_t& start){ return state_space_t<stones_t>(start, successors<stones_t>(transitions)); },
+	[](const stones_t& stones){
+		return !stones.empty() && stones.size() <= 17 &&
+			std::all_of(stones.begin(), stones.end(), [](frog_t frog){ return frog <= frog_t::brown; });
+	},
+	[](const stones_t& start, const stones_t& stones){ return std::equal(stones.begin(), stones.end(), start.rbegin()); }};
+
+puzzle_service_t<actors_t> crossing_service{
+	[](const actors_t& start){
+		auto space = state_space_t<actors_t>(start, successors<actors_t>(transitions), &is_valid);
+		space.set_batch_invariant(&is_valid_batch);
+		return space;
+	},
+	[](const actors_t& actors){
+		return std::all_of(actors.begin(), actors.end(), [](pos_t pos){ return pos <= pos_t::shore2; });
+	},
+	[](const actors_t&, const actors_t& actors){
+		return std::count(actors.begin(), actors.end(), pos_t::shore2) == static_cast<long>(actors.size());
+	}};
+
+puzzle_service_t<state_t, cost_t> family_service{
+	[](const state_t& start){
+		auto space = state_space_t<state_t, cost_t>(start, cost_t{}, successors<state_t>(transitions),
+													&river_crossing_valid);
+		space.set_cost([](const state_t&, const cost_t& cost){ return cost_t{cost.depth+1, cost.noise}; });
+		space.set_batch_invariant(&river_crossing_valid_batch);
+		return space;
+	},
+	[](const state_t& state){
+		return state.boat.pos <= boat_t::shore2 && river_crossing_valid(state) &&
+			std::all_of(state.persons.begin(), state.persons.end(),
+						[](const person_t& person){ return person.pos <= person_t::shore2; });
+	},
+	[](const state_t&, const state_t& state){ return goal(state); }};
+
+std::string answer(const solver_request_t& request, const std::string& start, const std::string& target) {
+	switch (request.puzzle) {
+	case frogs_puzzle: return frogs_service.answer(request.order, start, target);
+	case crossing_puzzle: return crossing_service.answer(request.order, start, target);
+	case family_puzzle: return family_service.answer(request.order, start, target);
+	}
+	auto header = solver_response_t{};
+	std::memcpy(header.magic, solver_response_magic, sizeof(header.magic));
+	header.status = solver_bad_request;
+	return std::string(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+// Answers the requests of one connection until the client closes it or sends something that is not a request, or the
+// connection is shut down because the daemon stops.
+void serve(int connection) {
+	auto request = solver_request_t{};
+	auto start = std::string{}, target = std::string{};
+	while (read_exact(connection, &request, sizeof(request))) {
+		if (std::memcmp(request.magic, solver_request_magic, sizeof(request.magic)) != 0 ||
+			request.startSize > solver_max_state_bytes || request.targetSize > solver_max_state_bytes)
+			break;
+		start.resize(request.startSize);
+		target.resize(request.targetSize);
+		if (!read_exact(connection, &start[0], start.size()) || !read_exact(connection, &target[0], target.size()))
+			break;
+		const auto begin = std::chrono::steady_clock::now();
+		auto response = answer(request, start, target);
+		const std::uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - begin).count();
+		std::memcpy(&response[offsetof(solver_response_t, nanoseconds)], &nanoseconds, sizeof(nanoseconds));
+		if (!write_exact(connection, response.data(), response.size()))
+			break;
+	}
+}
+
+std::mutex connections_mutex;
+std::condition_variable connection_closed;
+std::unordered_set<int> connections; // the connections being served
+
+volatile std::sig_atomic_t stopping = 0;
+
+void stop(int) { stopping = 1; }
+
+int main(int argc, char* argv[]) {
+	const auto path = std::string{argc > 1 ? argv[1] : solver_default_socket};
+	auto address = sockaddr_un{};
+	if (!solver_address(path, address)) {
+		std::cerr << "Socket path is too long: " << path << std::endl;
+		return 1;
+	}
+	auto listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	::unlink(path.c_str());
+	if (listener < 0 || ::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+		::listen(listener, 64) != 0) {
+		std::perror(path.c_str());
+		return 1;
+	}
+
+	// Without SA_RESTART the signals interrupt accept, so the daemon can remove its socket before it exits.
+	struct sigaction action{};
+	action.sa_handler = stop;
+	sigemptyset(&action.sa_mask);
+	::sigaction(SIGINT, &action, nullptr);
+	::sigaction(SIGTERM, &action, nullptr);
+
+	std::cout << "Serving puzzles on " << path << std::endl;
+	while (!stopping) {
+		{
+			// waits in slices, so that a signal stops the daemon while all connections are busy
+			auto lock = std::unique_lock<std::mutex>(connections_mutex);
+			if (!connection_closed.wait_for(lock, std::chrono::milliseconds(100),
+											[]{ return connections.size() < max_connections; }))
+				continue;
+		}
+		auto connection = ::accept(listener, nullptr, nullptr);
+		if (connection < 0)
+			continue;
+		{
+			auto lock = std::lock_guard<std::mutex>(connections_mutex);
+			connections.insert(connection);
+		}
+		std::thread([connection]{
+			serve(connection);
+			auto lock = std::lock_guard<std::mutex>(connections_mutex);
+			connections.erase(connection);
+			::close(connection);
+			connection_closed.notify_all();
+		}).detach();
+	}
+	::close(listener);
+	::unlink(path.c_str());
+
+	// The services are destroyed when main returns, so the connections are shut down, which ends their reads, and the
+	// threads are waited for. A request that is being solved is finished first.
+	auto lock = std::unique_lock<std::mutex>(connections_mutex);
+	for (auto connection: connections)
+		::shutdown(connection, SHUT_RDWR);
+	connection_closed.wait(lock, []{ return connections.empty(); });
+}
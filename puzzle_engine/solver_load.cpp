@@ -0,0 +1,158 @@
+/**
+ * Load generator for the solver daemon. Opens a number of connections to the daemon and sends requests over each of
+ * them, cycling through a fixed mix of queries on all three puzzles, one request at a time per connection. The round
+ * trip time of every request is measured, and the percentiles are reported separately for the requests that needed a
+ * search and for the repeated queries that the daemon answered from its cache.
+ * Compile and run (with solver_daemon running):
+ * g++ -std=c++17 -pedantic -Wall -DNDEBUG -O3 -pthread -o solver_load solver_load.cpp
+ * ./solver_load [socket] [requests per connection] [connections]
+ */
+#include "frogs.hpp"
+#include "crossing.hpp"
+#include "family.hpp"
+#include "solver_protocol.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// One request of the mix, with the status it should be answered with.
+struct query_t {
+	std::string request;
+	solver_status_t expected;
+};
+
+template<class StateTypeT>
+query_t make_query(solver_puzzle_t puzzle, search_order_t order, const StateTypeT& start,
+				   const StateTypeT* target, solver_status_t expected) {
+	auto startKey = std::string{}, targetKey = std::string{};
+	pack_state(start, startKey);
+	if (target != nullptr)
+		pack_state(*target, targetKey);
+	auto header = solver_request_t{};
+	std::memcpy(header.magic, solver_request_magic, sizeof(header.magic));
+	header.puzzle = puzzle;
+	header.order = static_cast<std::uint8_t>(order);
+	header.startSize = static_cast<std::uint32_t>(startKey.size());
+	header.targetSize = static_cast<std::uint32_t>(targetKey.size());
+	auto request = std::string(reinterpret_cast<const char*>(&header), sizeof(header));
+	return {request + startKey + targetKey, expected};
+}
+
+std::vector<query_t> query_mix() {
+	auto queries = std::vector<query_t>{};
+	for (auto frogs = std::size_t{1}; frogs <= 5; ++frogs) {
+		auto start = stones_t(frogs*2+1, frog_t::empty);
+		for (auto i = std::size_t{0}; i < frogs; ++i) {
+			start[i] = frog_t::green;
+			start[start.size()-i-1] = frog_t::brown;
+		}
+		for (auto order: {search_order_t::breadth_first, search_order_t::depth_first})
+			queries.push_back(make_query<stones_t>(frogs_puzzle, order, start, nullptr, solver_solved));
+		// the empty stone at either end, and only green frogs which cannot be reached as no frog changes colour:
+		auto left = start, right = start, stuck = stones_t(start.size(), frog_t::green);
+		std::rotate(left.begin(), left.begin()+frogs, left.begin()+frogs+1);
+		std::rotate(right.begin()+frogs, right.begin()+frogs+1, right.end());
+		stuck[frogs] = frog_t::empty;
+		queries.push_back(make_query(frogs_puzzle, search_order_t::breadth_first, start, &left, solver_solved));
+		queries.push_back(make_query(frogs_puzzle, search_order_t::breadth_first, start, &right, solver_solved));
+		queries.push_back(make_query(frogs_puzzle, search_order_t::breadth_first, start, &stuck, solver_unreachable));
+	}
+	for (auto order: {search_order_t::breadth_first, search_order_t::depth_first})
+		queries.push_back(make_query<actors_t>(crossing_puzzle, order, actors_t{}, nullptr, solver_solved));
+	queries.push_back(make_query<state_t>(family_puzzle, search_order_t::breadth_first, state_t{}, nullptr,
+										  solver_solved));
+	return queries;
+}
+
+struct sample_t {
+	double microseconds;
+	bool cached;
+};
+
+// Sends requests queries from the mix over one connection, starting at query first. Returns false if the daemon
+// could not be reached or answered something unexpected.
+bool run(const std::string& path, const std::vector<query_t>& queries, std::size_t first, std::size_t requests,
+		 std::vector<sample_t>& samples) {
+	auto address = sockaddr_un{};
+	auto connection = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (!solver_address(path, address) || connection < 0 ||
+		::connect(connection, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+		std::perror(path.c_str());
+		return false;
+	}
+	auto response = solver_response_t{};
+	auto trace = std::string{};
+	auto valid = true;
+	for (auto i = std::size_t{0}; valid && i < requests; ++i) {
+		auto& query = queries[(first + i) % queries.size()];
+		const auto begin = std::chrono::steady_clock::now();
+		valid = write_exact(connection, query.request.data(), query.request.size()) &&
+			read_exact(connection, &response, sizeof(response));
+		if (valid) {
+			trace.resize(response.traceSize);
+			valid = read_exact(connection, &trace[0], trace.size());
+		}
+		const auto end = std::chrono::steady_clock::now();
+		if (!valid || std::memcmp(response.magic, solver_response_magic, sizeof(response.magic)) != 0 ||
+			response.status != query.expected) {
+			std::cerr << "Unexpected answer to query " << (first + i) % queries.size() << std::endl;
+			valid = false;
+			break;
+		}
+		samples.push_back({std::chrono::duration<double, std::micro>(end - begin).count(), response.cached != 0});
+	}
+	::close(connection);
+	return valid;
+}
+
+void report(const char* name, std::vector<double> latencies) {
+	if (latencies.empty()) {
+		std::printf("%-9s %8d\n", name, 0);
+		return;
+	}
+	std::sort(latencies.begin(), latencies.end());
+	auto percentile = [&](double p){
+		return latencies[std::min(latencies.size()-1, static_cast<std::size_t>(p * latencies.size()))];
+	};
+	std::printf("%-9s %8zu %10.1f %10.1f %10.1f\n", name, latencies.size(), percentile(0.5), percentile(0.99),
+				latencies.back());
+}
+
+int main(int argc, char* argv[]) {
+	const auto path = std::string{argc > 1 ? argv[1] : solver_default_socket};
+	const auto requests = argc > 2 ? std::stoul(argv[2]) : 10000ul;
+	const auto connections = argc > 3 ? std::stoul(argv[3]) : 4ul;
+	const auto queries = query_mix();
+
+	auto samples = std::vector<std::vector<sample_t>>(connections);
+	auto valid = std::vector<char>(connections, 0);
+	auto threads = std::vector<std::thread>{};
+	const auto begin = std::chrono::steady_clock::now();
+	for (auto c = std::size_t{0}; c < connections; ++c)
+		threads.emplace_back([&, c]{ valid[c] = run(path, queries, c, requests, samples[c]); });
+	for (auto& thread: threads)
+		thread.join();
+	const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+	auto searched = std::vector<double>{}, cached = std::vector<double>{}, all = std::vector<double>{};
+	for (auto& connection: samples)
+		for (auto& sample: connection) {
+			(sample.cached ? cached : searched).push_back(sample.microseconds);
+			all.push_back(sample.microseconds);
+		}
+	std::printf("%zu requests over %lu connections in %.3f s, %.0f requests per second\n", all.size(), connections,
+				seconds, static_cast<double>(all.size()) / seconds);
+	std::printf("%-9s %8s %10s %10s %10s\n", "answers", "count", "p50 us", "p99 us", "max us");
+	report("searched", searched);
+	report("cached", cached);
+	report("all", all);
+	return std::all_of(valid.begin(), valid.end(), [](char v){ return v != 0; }) ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+/**
+ * Solving many independent instances of one model on several threads. A job gives the start state, the goal and the
+ * search options of one instance. A solver_pool_t keeps a number of worker threads, each with its own copy of the
+ * model, so the jobs can change the start state and cost of their worker's model, and every worker reuses its model,
+ * including its cached graph, from one job to the next. The searches of a worker also reuse the scratch memory of its
+ * thread, see scratch_pool_t, which the worker releases when a batch of jobs ends. Jobs are handed out one at a time
+ * from a shared counter, which keeps all workers busy even when the jobs differ a lot in size. The results are
+ * returned in the order of the jobs.
+ */
+
+#ifndef PUZZLEENGINE_SOLVER_POOL_HPP
+#define PUZZLEENGINE_SOLVER_POOL_HPP
+
+#include "reachability.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+template<class StateTypeT, class CostTypeT = std::nullptr_t>
+struct solve_job_t {
+    StateTypeT start;
+    std::function<bool(const StateTypeT &)> goal;
+    search_order_t order{breadth_first};
+    // Replaces the cost function of the model for this job, if set.
+    std::function<CostTypeT(const StateTypeT &, const CostTypeT &)> cost{};
+};
+
+template<class StateTypeT>
+struct solve_result_t {
+    std::list<StateTypeT> trace;
+    search_statistics_t statistics;
+    double seconds{0};        // the wall clock time of the job
+    std::size_t worker{0};    // the worker that ran the job
+    std::exception_ptr error; // set if the job threw an exception, in which case the trace is empty
+};
+
+template<class StateTypeT, class CostTypeT = std::nullptr_t>
+class solver_pool_t {
+public:
+    using job_t = solve_job_t<StateTypeT, CostTypeT>;
+    using result_t = solve_result_t<StateTypeT>;
+
+    // Starts threads workers, one per hardware thread if threads is zero, each with a copy of model.
+    explicit solver_pool_t(const state_space_t<StateTypeT, CostTypeT> &model, std::size_t threads = 0)
+            : _model(model) {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        _workers.resize(threads, worker_t{model, false});
+        for (std::size_t worker = 0; worker < threads; ++worker) {
+            _threads.emplace_back([this, worker]() { work(worker); });
+        }
+    }
+
+    solver_pool_t(const solver_pool_t &) = delete;
+
+    solver_pool_t &operator=(const solver_pool_t &) = delete;
+
+    ~solver_pool_t() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _wake.notify_all();
+        for (auto &thread: _threads) {
+            thread.join();
+        }
+    }
+
+    std::size_t size() const {
+        return _threads.size();
+    }
+
+    // Runs all jobs and returns their results in the order of jobs. Calls are served one at a time.
+    std::vector<result_t> solve(const std::vector<job_t> &jobs) {
+        std::lock_guard<std::mutex> batch(_batchMutex);
+        std::vector<result_t> results(jobs.size());
+        std::unique_lock<std::mutex> lock(_mutex);
+        _jobs = &jobs;
+        _results = &results;
+        _next = 0;
+        _busy = _threads.size();
+        ++_generation;
+        _wake.notify_all();
+        _done.wait(lock, [this]() { return _busy == 0; });
+        _jobs = nullptr;
+        _results = nullptr;
+        return results;
+    }
+
+private:
+    struct worker_t {
+        state_space_t<StateTypeT, CostTypeT> model;
+        bool costReplaced; // the model runs with the cost function of an earlier job
+    };
+
+    state_space_t<StateTypeT, CostTypeT> _model;
+    std::vector<worker_t> _workers;
+    std::vector<std::thread> _threads;
+    std::mutex _batchMutex;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    const std::vector<job_t> *_jobs{nullptr};
+    std::vector<result_t> *_results{nullptr};
+    std::atomic<std::size_t> _next{0};
+    std::size_t _busy{0};
+    std::size_t _generation{0};
+    bool _stopping{false};
+
+    void work(std::size_t worker) {
+        std::size_t generation = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _wake.wait(lock, [&]() { return _stopping || _generation != generation; });
+                if (_stopping) {
+                    return;
+                }
+                generation = _generation;
+            }
+            for (auto index = _next++; index < _jobs->size(); index = _next++) {
+                run(worker, (*_jobs)[index], (*_results)[index]);
+            }
+            trim_scratch_pools();
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (--_busy == 0) {
+                _done.notify_one();
+            }
+        }
+    }
+
+    void run(std::size_t worker, const job_t &job, result_t &result) {
+        auto &state = _workers[worker];
+        const auto start = std::chrono::steady_clock::now();
+        try {
+            if (job.cost) {
+                state.model.set_cost(job.cost);
+                state.costReplaced = true;
+            } else if (state.costReplaced) {
+                state.model = _model;
+                state.costReplaced = false;
+            }
+            state.model.set_start_state(job.start);
+            result.trace = state.model.check(job.goal, job.order);
+            result.statistics = state.model.statistics();
+        } catch (...) {
+            result.error = std::current_exception();
+        }
+        result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.worker = worker;
+    }
+};
+
+#endif //PUZZLEENGINE_SOLVER_POOL_HPP
@@ -0,0 +1,108 @@
+/**
+ * The binary protocol of the solver daemon. A client connects to the Unix domain socket of the daemon and sends any
+ * number of requests over the connection, each answered by one response before the next request is read.
+ * A request is a solver_request_t followed by the packed start state and the packed target state (see pack_state).
+ * Without a target the daemon searches for the goal of the puzzle. A response is a solver_response_t followed by the
+ * trace, each state as a 32 bit size and its packed bytes, from the start state to the goal. Numbers are in the byte
+ * order of the machine, as both sides run on the same host.
+ */
+
+#ifndef PUZZLEENGINE_SOLVER_PROTOCOL_HPP
+#define PUZZLEENGINE_SOLVER_PROTOCOL_HPP
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+constexpr char solver_request_magic[4] = {'P', 'E', 'Q', '1'};
+constexpr char solver_response_magic[4] = {'P', 'E', 'R', '1'};
+
+// Requests with more bytes of states than this are rejected and the connection is closed.
+constexpr std::uint32_t solver_max_state_bytes = 1 << 16;
+
+constexpr const char *solver_default_socket = "/tmp/puzzle_engine.sock";
+
+enum solver_puzzle_t : std::uint8_t {
+    frogs_puzzle,    // stones_t, the goal swaps the frogs
+    crossing_puzzle, // actors_t, the goal has all actors on shore2
+    family_puzzle    // state_t searched by depth as cost, the goal has all persons on shore2
+};
+
+enum solver_status_t : std::uint8_t {
+    solver_solved,      // the trace leads to the goal
+    solver_unreachable, // the goal cannot be reached, the trace is empty
+    solver_bad_request  // the puzzle, order or states are not valid, the trace is empty
+};
+
+struct solver_request_t {
+    char magic[4];
+    std::uint8_t puzzle;      // a solver_puzzle_t
+    std::uint8_t order;       // a search_order_t, ignored by searches with a cost
+    std::uint8_t reserved[2];
+    std::uint32_t startSize;  // bytes of the packed start state
+    std::uint32_t targetSize; // bytes of the packed target state, zero for the goal of the puzzle
+};
+
+struct solver_response_t {
+    char magic[4];
+    std::uint8_t status;      // a solver_status_t
+    std::uint8_t cached;      // one if the answer was kept from an earlier request
+    std::uint8_t reserved[2];
+    std::uint32_t stateCount; // states of the trace
+    std::uint32_t traceSize;  // bytes of the trace
+    std::uint64_t expanded;   // the counters of the search that found the answer
+    std::uint64_t generated;
+    std::uint64_t nanoseconds; // the time the daemon took to answer
+};
+
+// Reads exactly size bytes, retrying after interrupts and short reads. Returns false on errors and at the end of input.
+inline bool read_exact(int fd, void *data, std::size_t size) {
+    auto *bytes = static_cast<char *>(data);
+    while (size > 0) {
+        auto count = ::read(fd, bytes, size);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        bytes += count;
+        size -= static_cast<std::size_t>(count);
+    }
+    return true;
+}
+
+inline bool write_exact(int fd, const void *data, std::size_t size) {
+    const auto *bytes = static_cast<const char *>(data);
+    while (size > 0) {
+        auto count = ::send(fd, bytes, size, MSG_NOSIGNAL);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        bytes += count;
+        size -= static_cast<std::size_t>(count);
+    }
+    return true;
+}
+
+// Fills address with a socket path. Returns false if the path is too long for a Unix domain socket.
+inline bool solver_address(const std::string &path, sockaddr_un &address) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+#endif //PUZZLEENGINE_SOLVER_PROTOCOL_HPP
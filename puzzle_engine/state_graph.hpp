@@ -0,0 +1,265 @@
+/**
+ * A file holding a whole explored state graph in compressed sparse row form, so that it can be analysed without the
+ * model. States are numbered in the order they were discovered. The file consists of:
+ * - a header with the counts and the positions of the three sections,
+ * - the state table: the packed key of every state, keyWidth bytes each,
+ * - the offsets: stateCount + 1 numbers of 64 bits, where the successors of state i are targets[offsets[i]] up to
+ *   targets[offsets[i + 1]],
+ * - the targets: edgeCount state numbers of 32 bits.
+ * Sections start at multiples of eight bytes and numbers are stored in the byte order of the writing machine, so a
+ * reader can map the file and use the sections in place. The writer streams the offsets and targets to temporary
+ * files while exploring, so neither has to fit in memory. explicit_graph_t is the same graph held in memory.
+ */
+
+#ifndef PUZZLEENGINE_STATE_GRAPH_HPP
+#define PUZZLEENGINE_STATE_GRAPH_HPP
+
+#include "serialization.hpp"
+#include "memory_accounting.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct state_graph_header_t {
+    char magic[8];
+    std::uint64_t stateCount;
+    std::uint64_t edgeCount;
+    std::uint64_t keyWidth;
+    std::uint64_t statesOffset;
+    std::uint64_t offsetsOffset;
+    std::uint64_t targetsOffset;
+};
+
+constexpr char state_graph_magic[8] = {'P', 'E', 'G', 'R', 'A', 'P', 'H', '1'};
+
+// Builds a state graph file. The successors of the states are added state by state in the order of their numbers,
+// and finish then writes the file from the keys of the states and the streamed sections.
+class state_graph_writer_t {
+public:
+    explicit state_graph_writer_t(std::string path) : _path(std::move(path)),
+                                                      _offsets(_path + ".offsets.tmp",
+                                                               std::ios::binary | std::ios::trunc),
+                                                      _targets(_path + ".targets.tmp",
+                                                               std::ios::binary | std::ios::trunc) {
+    }
+
+    ~state_graph_writer_t() {
+        _offsets.close();
+        _targets.close();
+        std::remove((_path + ".offsets.tmp").c_str());
+        std::remove((_path + ".targets.tmp").c_str());
+    }
+
+    bool good() const {
+        return _offsets.good() && _targets.good();
+    }
+
+    // Starts the successors of the next state.
+    void begin_state() {
+        _offsets.write(reinterpret_cast<const char *>(&_edges), sizeof(_edges));
+    }
+
+    void add_edge(std::uint32_t target) {
+        _targets.write(reinterpret_cast<const char *>(&target), sizeof(target));
+        ++_edges;
+    }
+
+    // Writes the file, taking the key of state i from key(i). The file is written next to the target and then renamed,
+    // so the file at path is always complete. Returns false if it could not be written.
+    template<class KeyFunctionT>
+    bool finish(std::uint64_t stateCount, std::uint64_t keyWidth, KeyFunctionT key) {
+        _offsets.write(reinterpret_cast<const char *>(&_edges), sizeof(_edges));
+        _offsets.close();
+        _targets.close();
+        if (!_offsets || !_targets) {
+            return false;
+        }
+
+        state_graph_header_t header{};
+        std::memcpy(header.magic, state_graph_magic, sizeof(state_graph_magic));
+        header.stateCount = stateCount;
+        header.edgeCount = _edges;
+        header.keyWidth = keyWidth;
+        header.statesOffset = sizeof(header);
+        header.offsetsOffset = align(header.statesOffset + stateCount * keyWidth);
+        header.targetsOffset = header.offsetsOffset + (stateCount + 1) * sizeof(std::uint64_t);
+
+        const auto temporaryPath = _path + ".tmp";
+        std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        for (std::uint64_t index = 0; index < stateCount; ++index) {
+            out.write(key(index), static_cast<std::streamsize>(keyWidth));
+        }
+        const char padding[8] = {};
+        out.write(padding, static_cast<std::streamsize>(header.offsetsOffset - header.statesOffset -
+                                                        stateCount * keyWidth));
+        append(out, _path + ".offsets.tmp");
+        append(out, _path + ".targets.tmp");
+        out.close();
+        if (!out) {
+            std::remove(temporaryPath.c_str());
+            return false;
+        }
+        return std::rename(temporaryPath.c_str(), _path.c_str()) == 0;
+    }
+
+private:
+    std::string _path;
+    std::ofstream _offsets;
+    std::ofstream _targets;
+    std::uint64_t _edges{0};
+
+    static std::uint64_t align(std::uint64_t offset) {
+        return (offset + 7) & ~std::uint64_t{7};
+    }
+
+    static void append(std::ofstream &out, const std::string &path) {
+        std::ifstream in(path, std::ios::binary);
+        std::vector<char> buffer(1 << 16);
+        while (in.read(buffer.data(), static_cast<std::streamsize>(buffer.size())) || in.gcount() > 0) {
+            out.write(buffer.data(), in.gcount());
+        }
+    }
+};
+
+// A state graph held in memory, in the same form as the file: the states by number, and the offsets of the successors
+// of every state into the targets.
+template<class StateTypeT>
+struct explicit_graph_t {
+    accounted_vector_t<StateTypeT, graph_memory> states;
+    accounted_vector_t<std::uint32_t, graph_memory> offsets;
+    accounted_vector_t<std::uint32_t, graph_memory> targets;
+
+    bool built() const {
+        return !offsets.empty();
+    }
+
+    std::size_t size() const {
+        return states.size();
+    }
+
+    void clear() {
+        states.clear();
+        offsets.clear();
+        targets.clear();
+    }
+};
+
+// A read-only view of a state graph file, mapped into memory.
+class state_graph_view_t {
+public:
+    // The successors of one state, usable in a range based for loop.
+    struct successors_t {
+        const std::uint32_t *first;
+        const std::uint32_t *last;
+
+        const std::uint32_t *begin() const {
+            return first;
+        }
+
+        const std::uint32_t *end() const {
+            return last;
+        }
+
+        std::size_t size() const {
+            return static_cast<std::size_t>(last - first);
+        }
+    };
+
+    state_graph_view_t() = default;
+
+    state_graph_view_t(const state_graph_view_t &) = delete;
+
+    state_graph_view_t &operator=(const state_graph_view_t &) = delete;
+
+    ~state_graph_view_t() {
+        close();
+    }
+
+    // Maps the file at path. Returns false if it cannot be read or is not a complete state graph file.
+    bool open(const std::string &path) {
+        close();
+        auto fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info{};
+        if (::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(state_graph_header_t)) {
+            ::close(fd);
+            return false;
+        }
+        _size = static_cast<std::size_t>(info.st_size);
+        auto *data = ::mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED) {
+            return false;
+        }
+        _data = static_cast<const unsigned char *>(data);
+        std::memcpy(&_header, _data, sizeof(_header));
+        if (std::memcmp(_header.magic, state_graph_magic, sizeof(state_graph_magic)) != 0 ||
+            _header.targetsOffset + _header.edgeCount * sizeof(std::uint32_t) != _size) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (_data != nullptr) {
+            ::munmap(const_cast<unsigned char *>(_data), _size);
+            _data = nullptr;
+            _size = 0;
+        }
+    }
+
+    std::size_t size() const {
+        return _header.stateCount;
+    }
+
+    std::size_t edge_count() const {
+        return _header.edgeCount;
+    }
+
+    std::size_t key_width() const {
+        return _header.keyWidth;
+    }
+
+    const char *key(std::size_t index) const {
+        return reinterpret_cast<const char *>(_data + _header.statesOffset + index * _header.keyWidth);
+    }
+
+    // Unpacks state number index into state. Returns false if the key does not fit StateTypeT.
+    template<class StateTypeT>
+    bool state(std::size_t index, StateTypeT &state) const {
+        return unpack_state(key(index), key_width(), state);
+    }
+
+    const std::uint64_t *offsets() const {
+        return reinterpret_cast<const std::uint64_t *>(_data + _header.offsetsOffset);
+    }
+
+    const std::uint32_t *targets() const {
+        return reinterpret_cast<const std::uint32_t *>(_data + _header.targetsOffset);
+    }
+
+    successors_t successors(std::size_t index) const {
+        return successors_t{targets() + offsets()[index], targets() + offsets()[index + 1]};
+    }
+
+private:
+    const unsigned char *_data{nullptr};
+    std::size_t _size{0};
+    state_graph_header_t _header{};
+};
+
+#endif //PUZZLEENGINE_STATE_GRAPH_HPP
@@ -0,0 +1,142 @@
+/**
+ * A hash based visited set. The states are kept in one flat vector in insertion order, and an open addressing table
+ * of slots refers to them by index. A slot also holds the upper half of the state's hash, so most mismatches are
+ * rejected without touching the states.
+ */
+
+#ifndef PUZZLEENGINE_VISITED_SET_HPP
+#define PUZZLEENGINE_VISITED_SET_HPP
+
+#include "event_trace.hpp"
+#include "hash.hpp"
+#include "memory_accounting.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+template<class StateTypeT, class HashT = state_hash<StateTypeT>, class EqualT = state_equal<StateTypeT>>
+class hash_visited_set_t {
+public:
+    std::size_t hash(const StateTypeT &state) const {
+        return HashT{}(state);
+    }
+
+    // Hints the processor to load the slot of hash, so probing a batch of states can overlap the memory accesses.
+    void prefetch(std::size_t hash) const {
+        if (!_slots.empty()) {
+            __builtin_prefetch(&_slots[hash & (_slots.size() - 1)]);
+        }
+    }
+
+    // Adds state, whose hash is given, unless it is present already. Returns the position of the state in insertion
+    // order and whether it was added.
+    std::pair<std::size_t, bool> find_or_insert(const StateTypeT &state, std::size_t hash) {
+        if ((_states.size() + 1) * 2 > _slots.size()) {
+            grow();
+        }
+        auto slot = probe(state, hash);
+        if (_slots[slot] != 0) {
+            return {(_slots[slot] & 0xFFFFFFFFull) - 1, false};
+        }
+        _states.push_back(state);
+        _stateBytes.add(static_cast<std::int64_t>(state_heap_bytes<StateTypeT>::of(_states.back())));
+        _hashes.push_back(hash);
+        _slots[slot] = entry(hash, _states.size() - 1);
+        return {_states.size() - 1, true};
+    }
+
+    std::pair<std::size_t, bool> find_or_insert(const StateTypeT &state) {
+        return find_or_insert(state, hash(state));
+    }
+
+    // Adds state, whose hash is given, unless it is present already. Returns whether it was added.
+    bool insert(const StateTypeT &state, std::size_t hash) {
+        return find_or_insert(state, hash).second;
+    }
+
+    bool insert(const StateTypeT &state) {
+        return insert(state, hash(state));
+    }
+
+    bool contains(const StateTypeT &state, std::size_t hash) const {
+        return !_slots.empty() && _slots[probe(state, hash)] != 0;
+    }
+
+    bool contains(const StateTypeT &state) const {
+        return contains(state, hash(state));
+    }
+
+    std::size_t size() const {
+        return _states.size();
+    }
+
+    // The stored states in insertion order.
+    const accounted_vector_t<StateTypeT, passed_memory> &states() const {
+        return _states;
+    }
+
+    // Calls fn with every state in insertion order.
+    template<class FunctionT>
+    void for_each(FunctionT fn) const {
+        for (auto &state: _states) {
+            fn(state);
+        }
+    }
+
+    // The bytes held by the set, not counting memory that the states themselves point to.
+    std::size_t memory() const {
+        return _states.capacity() * sizeof(StateTypeT) + _hashes.capacity() * sizeof(std::size_t) +
+               _slots.capacity() * sizeof(std::uint64_t);
+    }
+
+    // Empties the set but keeps its memory for the next search.
+    void clear() {
+        _states.clear();
+        _stateBytes.reset();
+        _hashes.clear();
+        std::fill(_slots.begin(), _slots.end(), 0);
+    }
+
+private:
+    accounted_vector_t<StateTypeT, passed_memory> _states;
+    accounted_vector_t<std::size_t, passed_memory> _hashes;
+    accounted_vector_t<std::uint64_t, passed_memory> _slots; // upper hash bits and index + 1 of the state, or 0 if empty
+    accounted_bytes_t<state_memory> _stateBytes;
+
+    static std::uint64_t entry(std::size_t hash, std::size_t index) {
+        return (static_cast<std::uint64_t>(hash) & 0xFFFFFFFF00000000ull) | (index + 1);
+    }
+
+    std::size_t probe(const StateTypeT &state, std::size_t hash) const {
+        const auto mask = _slots.size() - 1;
+        const auto tag = static_cast<std::uint64_t>(hash) & 0xFFFFFFFF00000000ull;
+        auto slot = hash & mask;
+        while (_slots[slot] != 0) {
+            if ((_slots[slot] & 0xFFFFFFFF00000000ull) == tag &&
+                EqualT{}(_states[(_slots[slot] & 0xFFFFFFFFull) - 1], state)) {
+                break;
+            }
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    void grow() {
+        trace_span_t span("visited", "rehash", "states", _states.size());
+        _slots.assign(_slots.empty() ? 1024 : _slots.size() * 2, 0);
+        const auto mask = _slots.size() - 1;
+        for (std::size_t index = 0; index < _states.size(); ++index) {
+            auto slot = _hashes[index] & mask;
+            while (_slots[slot] != 0) {
+                slot = (slot + 1) & mask;
+            }
+            _slots[slot] = entry(_hashes[index], index);
+        }
+    }
+};
+
+#endif //PUZZLEENGINE_VISITED_SET_HPP
@@ -0,0 +1,313 @@
+/**
+ * A persistent visited set kept in a memory mapped file. States are stored as fixed width packed keys together with
+ * the index of their parent and their depth, in the order they were discovered by a breadth first search. An open
+ * addressing table over the records makes lookups cheap. As the records carry the parent links, a later run on the
+ * same model and start state can produce traces directly from the file, and an incomplete exploration can be
+ * extended where it stopped.
+ * A writer marks the store dirty while it has it open and clears the mark when it closes the store, after flushing the
+ * records and the table. A store that is found dirty, or whose size does not match its capacity, was left by a writer
+ * that did not close it, e.g. one that crashed while growing the file, and its table is rebuilt from the records the
+ * header counts when it is opened for writing again.
+ */
+
+#ifndef PUZZLEENGINE_VISITED_STORE_HPP
+#define PUZZLEENGINE_VISITED_STORE_HPP
+
+#include "hash.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class mmap_visited_set_t {
+public:
+    enum class open_mode_t {
+        read_only, read_write
+    };
+
+    static constexpr std::uint32_t npos = UINT32_MAX;
+
+    mmap_visited_set_t() = default;
+
+    mmap_visited_set_t(const mmap_visited_set_t &) = delete;
+
+    mmap_visited_set_t &operator=(const mmap_visited_set_t &) = delete;
+
+    ~mmap_visited_set_t() {
+        close();
+    }
+
+    // Opens the store at path. The fingerprint identifies the model and start state the store was built for, and
+    // keyWidth is the size of the packed keys. In read_only mode the file must already exist with the same fingerprint
+    // and key width and must have been closed by its last writer. In read_write mode a store that was not closed is
+    // repaired, and a missing or mismatching file is replaced by an empty store.
+    // The file is locked until the store is closed: shared in read_only mode and exclusive in read_write mode, so
+    // processes opening the same store wait for a writer instead of reading records while it extends them.
+    // Returns false if the store could not be opened.
+    bool open(const std::string &path, std::uint64_t fingerprint, std::size_t keyWidth, open_mode_t mode) {
+        close();
+        _writable = mode == open_mode_t::read_write;
+        _fd = ::open(path.c_str(), _writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+        if (_fd < 0) {
+            return false;
+        }
+        while (::flock(_fd, _writable ? LOCK_EX : LOCK_SH) != 0) {
+            if (errno != EINTR) {
+                close();
+                return false;
+            }
+        }
+
+        struct stat info{};
+        if (::fstat(_fd, &info) == 0 && static_cast<std::size_t>(info.st_size) >= sizeof(header_t)) {
+            header_t header{};
+            if (::pread(_fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+                std::memcmp(header.magic, magic, sizeof(magic)) == 0 && header.fingerprint == fingerprint &&
+                header.keyWidth == keyWidth && header.capacity >= initialCapacity &&
+                (header.capacity & (header.capacity - 1)) == 0 && header.count <= header.capacity &&
+                header.expanded <= header.count) {
+                const auto intact = header.dirty == 0 && static_cast<std::size_t>(info.st_size) ==
+                                                         fileSize(header.capacity, recordWidthFor(keyWidth));
+                if (!_writable) {
+                    if (intact && map(header.capacity, keyWidth)) {
+                        return true;
+                    }
+                    close();
+                    return false;
+                }
+                if (intact ? map(header.capacity, keyWidth) && markDirty() : rebuild(header)) {
+                    return true;
+                }
+            }
+        }
+        if (!_writable) {
+            close();
+            return false;
+        }
+
+        // Start over with an empty store.
+        header_t header{};
+        std::memcpy(header.magic, magic, sizeof(magic));
+        header.fingerprint = fingerprint;
+        header.keyWidth = keyWidth;
+        header.capacity = initialCapacity;
+        if (_data != nullptr) {
+            ::munmap(_data, _size);
+            _data = nullptr;
+        }
+        if (::ftruncate(_fd, 0) != 0 || !rebuild(header)) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    // A writer flushes the records and the table before it clears the dirty mark, so the mark only reaches the disk
+    // once everything it covers has.
+    void close() {
+        if (_data != nullptr) {
+            if (_writable && ::msync(_data, _size, MS_SYNC) == 0) {
+                header().dirty = 0;
+                ::msync(_data, sizeof(header_t), MS_SYNC);
+            }
+            ::munmap(_data, _size);
+            _data = nullptr;
+            _size = 0;
+        }
+        if (_fd >= 0) {
+            ::close(_fd);
+            _fd = -1;
+        }
+    }
+
+    bool is_open() const {
+        return _data != nullptr;
+    }
+
+    bool writable() const {
+        return _writable;
+    }
+
+    // Adds the key with the given parent record and depth unless it is present already. Returns the record of the key
+    // and whether it was added. Returns npos if the store is read-only or cannot grow.
+    std::pair<std::uint32_t, bool> insert(const void *key, std::uint32_t parent, std::uint32_t depth) {
+        auto slot = probe(key);
+        if (slots()[slot] != 0) {
+            return {slots()[slot] - 1, false};
+        }
+        if (!_writable) {
+            return {npos, false};
+        }
+        if (header().count == header().capacity) {
+            if (!grow()) {
+                return {npos, false};
+            }
+            slot = probe(key);
+        }
+        auto index = static_cast<std::uint32_t>(header().count);
+        auto *target = record(index);
+        std::memcpy(target, &parent, sizeof(parent));
+        std::memcpy(target + sizeof(parent), &depth, sizeof(depth));
+        std::memcpy(target + recordHeader, key, header().keyWidth);
+        slots()[slot] = index + 1;
+        ++header().count;
+        return {index, true};
+    }
+
+    // Returns the record of the key or npos if it is not stored.
+    std::uint32_t find(const void *key) const {
+        auto value = slots()[probe(key)];
+        return value == 0 ? npos : value - 1;
+    }
+
+    const char *key(std::uint32_t index) const {
+        return reinterpret_cast<const char *>(record(index) + recordHeader);
+    }
+
+    std::uint32_t parent(std::uint32_t index) const {
+        std::uint32_t value;
+        std::memcpy(&value, record(index), sizeof(value));
+        return value;
+    }
+
+    std::uint32_t depth(std::uint32_t index) const {
+        std::uint32_t value;
+        std::memcpy(&value, record(index) + sizeof(std::uint32_t), sizeof(value));
+        return value;
+    }
+
+    std::size_t key_width() const {
+        return header().keyWidth;
+    }
+
+    std::size_t size() const {
+        return header().count;
+    }
+
+    // The number of records whose successors have all been stored. Records from this index on form the frontier of
+    // the exploration, and the exploration is complete when every record has been expanded.
+    std::size_t expanded() const {
+        return header().expanded;
+    }
+
+    void set_expanded(std::size_t count) {
+        header().expanded = count;
+    }
+
+    bool complete() const {
+        return header().expanded == header().count;
+    }
+
+    // The hash used for the table and for building fingerprints.
+    static std::uint64_t hash(const void *bytes, std::size_t size, std::uint64_t seed = 0) {
+        return hash_bytes(bytes, size, seed);
+    }
+
+private:
+    struct header_t {
+        char magic[8];
+        std::uint64_t fingerprint;
+        std::uint64_t keyWidth;
+        std::uint64_t capacity; // number of records the file has room for, the table has twice as many slots
+        std::uint64_t count;
+        std::uint64_t expanded;
+        std::uint64_t dirty; // set while a writer has the store open
+    };
+
+    static constexpr char magic[8] = {'P', 'E', 'V', 'I', 'S', '0', '0', '3'};
+    static constexpr std::size_t recordHeader = 2 * sizeof(std::uint32_t); // parent and depth
+    static constexpr std::uint64_t initialCapacity = 1024;
+
+    int _fd{-1};
+    bool _writable{false};
+    unsigned char *_data{nullptr};
+    std::size_t _size{0};
+    std::size_t _recordWidth{0};
+
+    static std::size_t recordWidthFor(std::size_t keyWidth) {
+        return (recordHeader + keyWidth + 7) / 8 * 8;
+    }
+
+    static std::size_t fileSize(std::uint64_t capacity, std::size_t recordWidth) {
+        return sizeof(header_t) + capacity * recordWidth + 2 * capacity * sizeof(std::uint32_t);
+    }
+
+    header_t &header() const {
+        return *reinterpret_cast<header_t *>(_data);
+    }
+
+    unsigned char *record(std::uint32_t index) const {
+        return _data + sizeof(header_t) + index * _recordWidth;
+    }
+
+    std::uint32_t *slots() const {
+        return reinterpret_cast<std::uint32_t *>(_data + sizeof(header_t) + header().capacity * _recordWidth);
+    }
+
+    // Linear probing over the table, returning the slot holding key or the empty slot where it belongs.
+    std::size_t probe(const void *key) const {
+        const auto mask = header().capacity * 2 - 1;
+        auto slot = hash(key, header().keyWidth) & mask;
+        while (slots()[slot] != 0 && std::memcmp(this->key(slots()[slot] - 1), key, header().keyWidth) != 0) {
+            slot = (slot + 1) & mask;
+        }
+        return slot;
+    }
+
+    bool map(std::uint64_t capacity, std::size_t keyWidth) {
+        _recordWidth = recordWidthFor(keyWidth);
+        _size = fileSize(capacity, _recordWidth);
+        auto *data = ::mmap(nullptr, _size, _writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, _fd, 0);
+        if (data == MAP_FAILED) {
+            _data = nullptr;
+            return false;
+        }
+        _data = static_cast<unsigned char *>(data);
+        return true;
+    }
+
+    // Sets the dirty mark and writes it to the disk before the store is changed.
+    bool markDirty() {
+        header().dirty = 1;
+        return ::msync(_data, sizeof(header_t), MS_SYNC) == 0;
+    }
+
+    // Doubles the capacity. The records are flushed first, and the store stays dirty until it is closed, so a crash
+    // while the file is resized or the table is rebuilt is repaired by the next writer.
+    bool grow() {
+        auto header = this->header();
+        header.capacity *= 2;
+        if (::msync(_data, _size, MS_SYNC) != 0) {
+            return false;
+        }
+        ::munmap(_data, _size);
+        _data = nullptr;
+        return rebuild(header);
+    }
+
+    // Sizes the file to header.capacity and rebuilds the table from the header.count records, which keep their place
+    // at the start of the file, so only the table that follows them changes. The store is left marked dirty.
+    bool rebuild(header_t header) {
+        header.dirty = 1;
+        if (::pwrite(_fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) || ::fsync(_fd) != 0 ||
+            ::ftruncate(_fd, static_cast<off_t>(fileSize(header.capacity, recordWidthFor(header.keyWidth)))) != 0 ||
+            !map(header.capacity, header.keyWidth)) {
+            return false;
+        }
+        std::memset(slots(), 0, 2 * header.capacity * sizeof(std::uint32_t));
+        for (std::uint32_t index = 0; index < header.count; ++index) {
+            slots()[probe(key(index))] = index + 1;
+        }
+        return true;
+    }
+};
+
+#endif //PUZZLEENGINE_VISITED_STORE_HPP